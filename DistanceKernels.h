@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// Instruction set used by the batched distance kernels
+// Scalar is always available; the others are x86 only and picked at runtime
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+// Totals produced while assigning points to their nearest centroid
+struct AssignmentResult {
+    double sum_distance = 0.0; // Sum of Euclidean distances to the nearest centroid
+    double sum_squared = 0.0;  // Sum of squared distances (WCSS)
+    size_t distance_evaluations = 0; // Point-to-centroid distances computed
+};
+
+// Batched nearest-centroid kernels working on row-major coordinate arrays
+// Distances are compared squared; a square root is taken once per point only
+// to report sum_distance. For float and double the kernels are vectorized
+// across points with SSE2/AVX2/AVX-512 and specialized at compile time for
+// dimensions 2, 3 and 8. assign_nearest returns bit-identical results with
+// every instruction set, also when the compiler may emit FMA instructions.
+// T - numeric type for point coordinates (e.g., double, float, int)
+template <typename T>
+class DistanceKernels {
+public:
+    // Type used to accumulate squared distances
+    // float stays in float to keep SIMD lanes full; everything else uses double
+    using Acc = std::conditional_t<std::is_same_v<T, float>, float, double>;
+
+    // Squared Euclidean distance between two coordinate arrays
+    // Inlined into its callers, which may fuse it into FMA instructions, so
+    // the last bit can differ from the distances of assign_nearest
+    // D - dimension known at compile time (0 = use dim)
+    template <size_t D = 0>
+    static Acc squared_distance(const T* a, const T* b, size_t dim);
+
+    // Finds the nearest and second nearest centroid of one point
+    // Returns the index of the nearest one (first one wins on ties) and
+    // stores both squared distances (rounded like squared_distance)
+    // D - dimension known at compile time (0 = use dim)
+    template <size_t D = 0>
+    static size_t nearest_two(const T* point, const T* centroids, size_t k, size_t dim,
+                              Acc& nearest, Acc& second);
+
+    // Assigns every point to its nearest centroid
+    // Parameters:
+    //   points - n x dim row-major coordinates
+    //   n - number of points
+    //   centroids - k x dim row-major coordinates
+    //   k - number of centroids (must be > 0)
+    //   dim - dimension of points and centroids
+    //   labels - output array of n cluster indices
+    // Returns:
+    //   Sum of distances and squared distances to the chosen centroids
+    static AssignmentResult assign_nearest(const T* points, size_t n,
+                                           const T* centroids, size_t k,
+                                           size_t dim, size_t* labels);
+
+    // Same as assign_nearest, also storing the squared distance from every
+    // point to its nearest and its second nearest centroid (max() if k == 1)
+    // Parameters:
+    //   nearest, second - output arrays of n squared distances
+    static AssignmentResult assign_nearest_two(const T* points, size_t n,
+                                               const T* centroids, size_t k,
+                                               size_t dim, size_t* labels,
+                                               Acc* nearest, Acc* second);
+
+    // Instruction set used by assign_nearest
+    static SimdLevel simd_level();
+
+    // Restricts the kernels to a lower instruction set (e.g. for benchmarking)
+    // Requests above what the CPU supports are clamped to the detected level
+    // Safe to call while other threads assign; they see the new level on a
+    // later call (every level gives the same labels)
+    static void set_simd_level(SimdLevel level);
+
+private:
+    // Only a dispatch hint, so relaxed loads and stores suffice
+    static std::atomic<SimdLevel>& active_level();
+
+    // Second - also store nearest and second nearest squared distances
+    template <bool Second>
+    static AssignmentResult assign(const T* points, size_t n,
+                                   const T* centroids, size_t k,
+                                   size_t dim, size_t* labels,
+                                   Acc* nearest, Acc* second);
+
+    template <size_t D, bool Second>
+    static void assign_scalar(const T* points, size_t n,
+                              const T* centroids, size_t k,
+                              size_t dim, size_t* labels,
+                              AssignmentResult& result,
+                              Acc* nearest, Acc* second);
+};
+
+// Detects the best instruction set supported by the running CPU
+SimdLevel detect_simd_level();
+
+// Human readable name of an instruction set
+const char* simd_level_name(SimdLevel level);
+
+#include "DistanceKernels.ipp"
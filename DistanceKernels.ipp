@@ -0,0 +1,519 @@
+#include "DistanceKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GENETIC_CLUSTERING_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define GENETIC_CLUSTERING_X86_SIMD 0
+#endif
+
+// Keeps GCC from fusing multiply-adds into FMA instructions (which it does
+// by default once FMA is enabled, e.g. with -march=native), so the scalar
+// kernel rounds like the vector kernels. Clang only fuses within one
+// expression and is handled with a pragma in the function body.
+#if defined(__GNUC__) && !defined(__clang__)
+#define GENETIC_CLUSTERING_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define GENETIC_CLUSTERING_NO_FP_CONTRACT
+#endif
+
+inline SimdLevel detect_simd_level() {
+#if GENETIC_CLUSTERING_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+#if GENETIC_CLUSTERING_X86_SIMD
+// Vector kernels. A block of L points is transposed into `block` so that one
+// register holds coordinate j of L points; each centroid is broadcast and the
+// running minimum and its index are kept per lane with a branchless blend.
+// D is the compile-time dimension, 0 means use dim. Points that do not fill a
+// whole block are left to the scalar kernel; the number processed is returned.
+// Lanes are assembled in registers before being stored, so reading the block
+// back never stalls on store forwarding. fp-contract is disabled so no lane
+// is fused into an FMA and every instruction set rounds like the scalar kernel.
+// With Second, the squared distances to the nearest and the second nearest
+// centroid of every point are also stored (min/max only, no extra rounding).
+
+// Adds the per-lane minima of one block to the labels and running totals
+template <typename Acc>
+inline void store_block(const Acc* best, const Acc* best_idx, size_t lanes, size_t* labels,
+                        double& sum_squared, double& sum_distance) {
+    for (size_t l = 0; l < lanes; ++l) {
+        labels[l] = static_cast<size_t>(best_idx[l]);
+        sum_squared += static_cast<double>(best[l]);
+        sum_distance += std::sqrt(static_cast<double>(best[l]));
+    }
+}
+
+template <size_t D, bool Second>
+__attribute__((target("sse2"), optimize("fp-contract=off")))
+size_t simd_assign_sse2(const double* points, size_t n, size_t dim, const double* centroids,
+                       size_t k, double* block, size_t* labels, AssignmentResult& result, double* nearest_out, double* second_out) {
+    constexpr size_t L = 2;
+    const size_t d = D ? D : dim;
+    alignas(64) double best_out[L];
+    alignas(64) double index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const double* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm_store_pd(block + j * L, _mm_set_pd(x[1 * d + j], x[j]));
+        }
+        __m128d best = _mm_set1_pd(std::numeric_limits<double>::max());
+        __m128d best_idx = _mm_setzero_pd();
+        __m128d second = _mm_set1_pd(std::numeric_limits<double>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const double* y = centroids + c * d;
+            __m128d acc = _mm_setzero_pd();
+            for (size_t j = 0; j < d; ++j) {
+                __m128d diff = _mm_sub_pd(_mm_load_pd(block + j * L), _mm_set1_pd(y[j]));
+                acc = _mm_add_pd(acc, _mm_mul_pd(diff, diff));
+            }
+            if constexpr (Second) second = _mm_min_pd(second, _mm_max_pd(best, acc));
+            __m128d closer = _mm_cmplt_pd(acc, best);
+            best = _mm_or_pd(_mm_and_pd(closer, acc), _mm_andnot_pd(closer, best));
+            best_idx = _mm_or_pd(_mm_and_pd(closer, _mm_set1_pd(static_cast<double>(c))),
+                                 _mm_andnot_pd(closer, best_idx));
+        }
+        _mm_store_pd(best_out, best);
+        _mm_store_pd(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm_storeu_pd(nearest_out + i, best);
+            _mm_storeu_pd(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+template <size_t D, bool Second>
+__attribute__((target("sse2"), optimize("fp-contract=off")))
+size_t simd_assign_sse2(const float* points, size_t n, size_t dim, const float* centroids,
+                       size_t k, float* block, size_t* labels, AssignmentResult& result, float* nearest_out, float* second_out) {
+    constexpr size_t L = 4;
+    const size_t d = D ? D : dim;
+    alignas(64) float best_out[L];
+    alignas(64) float index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const float* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm_store_ps(block + j * L, _mm_set_ps(x[3 * d + j], x[2 * d + j], x[1 * d + j], x[j]));
+        }
+        __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+        __m128 best_idx = _mm_setzero_ps();
+        __m128 second = _mm_set1_ps(std::numeric_limits<float>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const float* y = centroids + c * d;
+            __m128 acc = _mm_setzero_ps();
+            for (size_t j = 0; j < d; ++j) {
+                __m128 diff = _mm_sub_ps(_mm_load_ps(block + j * L), _mm_set1_ps(y[j]));
+                acc = _mm_add_ps(acc, _mm_mul_ps(diff, diff));
+            }
+            if constexpr (Second) second = _mm_min_ps(second, _mm_max_ps(best, acc));
+            __m128 closer = _mm_cmplt_ps(acc, best);
+            best = _mm_or_ps(_mm_and_ps(closer, acc), _mm_andnot_ps(closer, best));
+            best_idx = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps(static_cast<float>(c))),
+                                 _mm_andnot_ps(closer, best_idx));
+        }
+        _mm_store_ps(best_out, best);
+        _mm_store_ps(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm_storeu_ps(nearest_out + i, best);
+            _mm_storeu_ps(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+template <size_t D, bool Second>
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+size_t simd_assign_avx2(const double* points, size_t n, size_t dim, const double* centroids,
+                       size_t k, double* block, size_t* labels, AssignmentResult& result, double* nearest_out, double* second_out) {
+    constexpr size_t L = 4;
+    const size_t d = D ? D : dim;
+    alignas(64) double best_out[L];
+    alignas(64) double index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const double* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm256_store_pd(block + j * L, _mm256_set_pd(x[3 * d + j], x[2 * d + j], x[1 * d + j], x[j]));
+        }
+        __m256d best = _mm256_set1_pd(std::numeric_limits<double>::max());
+        __m256d best_idx = _mm256_setzero_pd();
+        __m256d second = _mm256_set1_pd(std::numeric_limits<double>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const double* y = centroids + c * d;
+            __m256d acc = _mm256_setzero_pd();
+            for (size_t j = 0; j < d; ++j) {
+                __m256d diff = _mm256_sub_pd(_mm256_load_pd(block + j * L), _mm256_set1_pd(y[j]));
+                acc = _mm256_add_pd(acc, _mm256_mul_pd(diff, diff));
+            }
+            if constexpr (Second) second = _mm256_min_pd(second, _mm256_max_pd(best, acc));
+            __m256d closer = _mm256_cmp_pd(acc, best, _CMP_LT_OQ);
+            best = _mm256_blendv_pd(best, acc, closer);
+            best_idx = _mm256_blendv_pd(best_idx, _mm256_set1_pd(static_cast<double>(c)), closer);
+        }
+        _mm256_store_pd(best_out, best);
+        _mm256_store_pd(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm256_storeu_pd(nearest_out + i, best);
+            _mm256_storeu_pd(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+template <size_t D, bool Second>
+__attribute__((target("avx2"), optimize("fp-contract=off")))
+size_t simd_assign_avx2(const float* points, size_t n, size_t dim, const float* centroids,
+                       size_t k, float* block, size_t* labels, AssignmentResult& result, float* nearest_out, float* second_out) {
+    constexpr size_t L = 8;
+    const size_t d = D ? D : dim;
+    alignas(64) float best_out[L];
+    alignas(64) float index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const float* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm256_store_ps(block + j * L, _mm256_set_ps(x[7 * d + j], x[6 * d + j], x[5 * d + j], x[4 * d + j], x[3 * d + j], x[2 * d + j], x[1 * d + j], x[j]));
+        }
+        __m256 best = _mm256_set1_ps(std::numeric_limits<float>::max());
+        __m256 best_idx = _mm256_setzero_ps();
+        __m256 second = _mm256_set1_ps(std::numeric_limits<float>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const float* y = centroids + c * d;
+            __m256 acc = _mm256_setzero_ps();
+            for (size_t j = 0; j < d; ++j) {
+                __m256 diff = _mm256_sub_ps(_mm256_load_ps(block + j * L), _mm256_set1_ps(y[j]));
+                acc = _mm256_add_ps(acc, _mm256_mul_ps(diff, diff));
+            }
+            if constexpr (Second) second = _mm256_min_ps(second, _mm256_max_ps(best, acc));
+            __m256 closer = _mm256_cmp_ps(acc, best, _CMP_LT_OQ);
+            best = _mm256_blendv_ps(best, acc, closer);
+            best_idx = _mm256_blendv_ps(best_idx, _mm256_set1_ps(static_cast<float>(c)), closer);
+        }
+        _mm256_store_ps(best_out, best);
+        _mm256_store_ps(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm256_storeu_ps(nearest_out + i, best);
+            _mm256_storeu_ps(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+template <size_t D, bool Second>
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+size_t simd_assign_avx512(const double* points, size_t n, size_t dim, const double* centroids,
+                         size_t k, double* block, size_t* labels, AssignmentResult& result, double* nearest_out, double* second_out) {
+    constexpr size_t L = 8;
+    const size_t d = D ? D : dim;
+    alignas(64) double best_out[L];
+    alignas(64) double index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const double* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm512_store_pd(block + j * L, _mm512_set_pd(x[7 * d + j], x[6 * d + j], x[5 * d + j], x[4 * d + j], x[3 * d + j], x[2 * d + j], x[1 * d + j], x[j]));
+        }
+        __m512d best = _mm512_set1_pd(std::numeric_limits<double>::max());
+        __m512d best_idx = _mm512_setzero_pd();
+        __m512d second = _mm512_set1_pd(std::numeric_limits<double>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const double* y = centroids + c * d;
+            __m512d acc = _mm512_setzero_pd();
+            for (size_t j = 0; j < d; ++j) {
+                __m512d diff = _mm512_sub_pd(_mm512_load_pd(block + j * L), _mm512_set1_pd(y[j]));
+                acc = _mm512_add_pd(acc, _mm512_mul_pd(diff, diff));
+            }
+            if constexpr (Second) {
+                // Blends instead of min/max, which warn under a target attribute in GCC 12
+                const auto farther = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(best, acc, _CMP_LT_OQ), best, acc);
+                second = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(farther, second, _CMP_LT_OQ), second, farther);
+            }
+            __mmask8 closer = _mm512_cmp_pd_mask(acc, best, _CMP_LT_OQ);
+            best = _mm512_mask_blend_pd(closer, best, acc);
+            best_idx = _mm512_mask_blend_pd(closer, best_idx, _mm512_set1_pd(static_cast<double>(c)));
+        }
+        _mm512_store_pd(best_out, best);
+        _mm512_store_pd(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm512_storeu_pd(nearest_out + i, best);
+            _mm512_storeu_pd(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+template <size_t D, bool Second>
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+size_t simd_assign_avx512(const float* points, size_t n, size_t dim, const float* centroids,
+                         size_t k, float* block, size_t* labels, AssignmentResult& result, float* nearest_out, float* second_out) {
+    constexpr size_t L = 16;
+    const size_t d = D ? D : dim;
+    alignas(64) float best_out[L];
+    alignas(64) float index_out[L];
+    double sum_squared = result.sum_squared;
+    double sum_distance = result.sum_distance;
+
+    size_t i = 0;
+    for (; i + L <= n; i += L) {
+        const float* x = points + i * d;
+        for (size_t j = 0; j < d; ++j) {
+            _mm512_store_ps(block + j * L, _mm512_set_ps(x[15 * d + j], x[14 * d + j], x[13 * d + j], x[12 * d + j], x[11 * d + j], x[10 * d + j], x[9 * d + j], x[8 * d + j], x[7 * d + j], x[6 * d + j], x[5 * d + j], x[4 * d + j], x[3 * d + j], x[2 * d + j], x[1 * d + j], x[j]));
+        }
+        __m512 best = _mm512_set1_ps(std::numeric_limits<float>::max());
+        __m512 best_idx = _mm512_setzero_ps();
+        __m512 second = _mm512_set1_ps(std::numeric_limits<float>::max());
+
+        for (size_t c = 0; c < k; ++c) {
+            const float* y = centroids + c * d;
+            __m512 acc = _mm512_setzero_ps();
+            for (size_t j = 0; j < d; ++j) {
+                __m512 diff = _mm512_sub_ps(_mm512_load_ps(block + j * L), _mm512_set1_ps(y[j]));
+                acc = _mm512_add_ps(acc, _mm512_mul_ps(diff, diff));
+            }
+            if constexpr (Second) {
+                // Blends instead of min/max, which warn under a target attribute in GCC 12
+                const auto farther = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(best, acc, _CMP_LT_OQ), best, acc);
+                second = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(farther, second, _CMP_LT_OQ), second, farther);
+            }
+            __mmask16 closer = _mm512_cmp_ps_mask(acc, best, _CMP_LT_OQ);
+            best = _mm512_mask_blend_ps(closer, best, acc);
+            best_idx = _mm512_mask_blend_ps(closer, best_idx, _mm512_set1_ps(static_cast<float>(c)));
+        }
+        _mm512_store_ps(best_out, best);
+        _mm512_store_ps(index_out, best_idx);
+        store_block(best_out, index_out, L, labels + i, sum_squared, sum_distance);
+        if constexpr (Second) {
+            _mm512_storeu_ps(nearest_out + i, best);
+            _mm512_storeu_ps(second_out + i, second);
+        }
+    }
+    result.sum_squared = sum_squared;
+    result.sum_distance = sum_distance;
+    return i;
+}
+
+// Runs the vector kernel of the given level for a compile-time dimension
+template <size_t D, bool Second, typename T>
+size_t simd_assign(SimdLevel level, const T* points, size_t n, size_t dim, const T* centroids,
+                   size_t k, T* block, size_t* labels, AssignmentResult& result,
+                   T* nearest, T* second) {
+    switch (level) {
+        case SimdLevel::AVX512:
+            return simd_assign_avx512<D, Second>(points, n, dim, centroids, k, block, labels, result, nearest, second);
+        case SimdLevel::AVX2:
+            return simd_assign_avx2<D, Second>(points, n, dim, centroids, k, block, labels, result, nearest, second);
+        default:
+            return simd_assign_sse2<D, Second>(points, n, dim, centroids, k, block, labels, result, nearest, second);
+    }
+}
+#endif
+
+template <typename T>
+template <size_t D>
+typename DistanceKernels<T>::Acc DistanceKernels<T>::squared_distance(const T* a, const T* b, size_t dim) {
+    const size_t d = D ? D : dim;
+    Acc sum = 0;
+    for (size_t j = 0; j < d; ++j) {
+        Acc diff = static_cast<Acc>(a[j]) - static_cast<Acc>(b[j]);
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+template <typename T>
+template <size_t D>
+size_t DistanceKernels<T>::nearest_two(const T* point, const T* centroids, size_t k, size_t dim,
+                                       Acc& nearest, Acc& second) {
+    const size_t d = D ? D : dim;
+    Acc best = std::numeric_limits<Acc>::max();
+    Acc runner_up = std::numeric_limits<Acc>::max();
+    size_t best_cluster = 0;
+
+    for (size_t c = 0; c < k; ++c) {
+        // Branch-free min/max updates: the winner changes unpredictably from
+        // point to point, so a branch here would mispredict constantly
+        const Acc dist = squared_distance<D>(point, centroids + c * d, d);
+        best_cluster = dist < best ? c : best_cluster;
+        runner_up = std::min(runner_up, std::max(best, dist));
+        best = std::min(best, dist);
+    }
+    nearest = best;
+    second = runner_up;
+    return best_cluster;
+}
+
+template <typename T>
+template <size_t D, bool Second>
+GENETIC_CLUSTERING_NO_FP_CONTRACT
+void DistanceKernels<T>::assign_scalar(const T* points, size_t n,
+                                       const T* centroids, size_t k,
+                                       size_t dim, size_t* labels,
+                                       AssignmentResult& result,
+                                       Acc* nearest, Acc* second) {
+#ifdef __clang__
+#pragma clang fp contract(off)
+#endif
+    const size_t d = D ? D : dim;
+
+    for (size_t i = 0; i < n; ++i) {
+        const T* x = points + i * d;
+        Acc best = std::numeric_limits<Acc>::max();
+        Acc runner_up = std::numeric_limits<Acc>::max();
+        size_t best_cluster = 0;
+
+        for (size_t c = 0; c < k; ++c) {
+            const T* y = centroids + c * d;
+            Acc dist = 0;
+            for (size_t j = 0; j < d; ++j) {
+                Acc diff = static_cast<Acc>(x[j]) - static_cast<Acc>(y[j]);
+                dist += diff * diff;
+            }
+            if constexpr (Second) runner_up = std::min(runner_up, std::max(best, dist));
+            if (dist < best) {
+                best = dist;
+                best_cluster = c;
+            }
+        }
+        labels[i] = best_cluster;
+        if constexpr (Second) {
+            nearest[i] = best;
+            second[i] = runner_up;
+        }
+        result.sum_squared += static_cast<double>(best);
+        result.sum_distance += std::sqrt(static_cast<double>(best));
+    }
+}
+
+template <typename T>
+AssignmentResult DistanceKernels<T>::assign_nearest(const T* points, size_t n,
+                                                    const T* centroids, size_t k,
+                                                    size_t dim, size_t* labels) {
+    return assign<false>(points, n, centroids, k, dim, labels, nullptr, nullptr);
+}
+
+template <typename T>
+AssignmentResult DistanceKernels<T>::assign_nearest_two(const T* points, size_t n,
+                                                        const T* centroids, size_t k,
+                                                        size_t dim, size_t* labels,
+                                                        Acc* nearest, Acc* second) {
+    return assign<true>(points, n, centroids, k, dim, labels, nearest, second);
+}
+
+template <typename T>
+template <bool Second>
+AssignmentResult DistanceKernels<T>::assign(const T* points, size_t n,
+                                            const T* centroids, size_t k,
+                                            size_t dim, size_t* labels,
+                                            Acc* nearest, Acc* second) {
+    AssignmentResult result;
+    result.distance_evaluations = n * k;
+    size_t done = 0;
+#if GENETIC_CLUSTERING_X86_SIMD
+    if constexpr (std::is_same_v<T, double> || std::is_same_v<T, float>) {
+        const SimdLevel level = simd_level();
+        if (level != SimdLevel::Scalar) {
+            // Per-thread, 64-byte aligned transpose buffer for one block of points;
+            // grows to the largest dimension seen and is then reused
+            thread_local std::vector<T> buffer;
+            const size_t block_size = dim * 64 / sizeof(T);
+            if (buffer.size() < block_size + 64 / sizeof(T)) buffer.resize(block_size + 64 / sizeof(T));
+            void* aligned = buffer.data();
+            size_t space = buffer.size() * sizeof(T);
+            T* block = static_cast<T*>(std::align(64, block_size * sizeof(T), aligned, space));
+
+            switch (dim) {
+                case 2: done = simd_assign<2, Second>(level, points, n, dim, centroids, k, block, labels, result, nearest, second); break;
+                case 3: done = simd_assign<3, Second>(level, points, n, dim, centroids, k, block, labels, result, nearest, second); break;
+                case 8: done = simd_assign<8, Second>(level, points, n, dim, centroids, k, block, labels, result, nearest, second); break;
+                default: done = simd_assign<0, Second>(level, points, n, dim, centroids, k, block, labels, result, nearest, second); break;
+            }
+        }
+    }
+#endif
+    // Scalar kernel handles everything without SIMD and the tail of the vector path
+    const T* rest = points + done * dim;
+    Acc* rest_nearest = Second ? nearest + done : nullptr;
+    Acc* rest_second = Second ? second + done : nullptr;
+    switch (dim) {
+        case 2: assign_scalar<2, Second>(rest, n - done, centroids, k, dim, labels + done, result, rest_nearest, rest_second); break;
+        case 3: assign_scalar<3, Second>(rest, n - done, centroids, k, dim, labels + done, result, rest_nearest, rest_second); break;
+        case 8: assign_scalar<8, Second>(rest, n - done, centroids, k, dim, labels + done, result, rest_nearest, rest_second); break;
+        default: assign_scalar<0, Second>(rest, n - done, centroids, k, dim, labels + done, result, rest_nearest, rest_second); break;
+    }
+    return result;
+}
+
+template <typename T>
+std::atomic<SimdLevel>& DistanceKernels<T>::active_level() {
+    static std::atomic<SimdLevel> level{detect_simd_level()};
+    return level;
+}
+
+template <typename T>
+SimdLevel DistanceKernels<T>::simd_level() {
+    return active_level().load(std::memory_order_relaxed);
+}
+
+template <typename T>
+void DistanceKernels<T>::set_simd_level(SimdLevel level) {
+    const SimdLevel detected = detect_simd_level();
+    active_level().store(static_cast<int>(level) < static_cast<int>(detected) ? level : detected,
+                         std::memory_order_relaxed);
+}
@@ -9,29 +9,41 @@ class DistanceMetric {
 public:
     virtual ~DistanceMetric() = default;
 
-    // Pure virtual function to compute distance between two points
+    // Pure virtual function to compute distance between two coordinate arrays
+    // Parameters:
+    //   a - coordinates of the first point (e.g. a PointMatrix row)
+    //   b - coordinates of the second point
+    //   dim - number of coordinates in each array
+    // Returns:
+    //   Distance between points as double
+    virtual double compute(const T* a, const T* b, size_t dim) const = 0;
+
+    // Computes distance between two points
     // Parameters:
     //   a - First point (const reference for efficiency)
     //   b - Second point (const reference for efficiency)
     // Returns:
     //   Distance between points as double
-    virtual double compute(const Point<T>& a, const Point<T>& b) const = 0;
+    double compute(const Point<T>& a, const Point<T>& b) const {
+        return compute(a.coors.data(), b.coors.data(), a.dimension());
+    }
 };
 
 // Derived class implementing Euclidean distance metric
 template <typename T>
 class EuclideanDistance : public DistanceMetric<T> {
 public:
+    using DistanceMetric<T>::compute;
+
     // Computes Euclidean distance between two points
     // Formula: sqrt(?(a_i - b_i)?)
     // Parameters:
     //   a - First point
     //   b - Second point
+    //   dim - dimension of both points
     // Returns:
     //   Euclidean distance between points
-    // Throws:
-    //   std::invalid_argument if points have different dimensions
-    double compute(const Point<T>& a, const Point<T>& b) const override;
+    double compute(const T* a, const T* b, size_t dim) const override;
 };
 
 #include "DistanceMetric.ipp"
\ No newline at end of file
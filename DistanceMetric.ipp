@@ -2,10 +2,10 @@
 #include <cmath>
 
 template <typename T>
-double EuclideanDistance<T>::compute(const Point<T>& a, const Point<T>& b) const {
+double EuclideanDistance<T>::compute(const T* a, const T* b, size_t dim) const {
     double sum = 0.0;
-    for (size_t i = 0; i < a.coors.size(); ++i) {
-        sum += (a.coors[i] - b.coors[i]) * (a.coors[i] - b.coors[i]);
+    for (size_t i = 0; i < dim; ++i) {
+        sum += (a[i] - b[i]) * (a[i] - b[i]);
     }
     return std::sqrt(sum);
 }
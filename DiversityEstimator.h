@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <random>
+#include "Individual.h"
+
+// Abstract base class for population diversity estimators
+// Diversity is measured between centroids with the same index in different
+// individuals (centroid c of individual i against centroid c of individual j)
+// T - numeric type of the centroid coordinates
+template <typename T>
+class DiversityEstimator {
+public:
+    // Virtual destructor for proper polymorphic deletion
+    virtual ~DiversityEstimator() = default;
+
+    // Pure virtual estimation
+    // population - individuals whose centroids are compared (k x d each)
+    // Returns a non-negative diversity value (0 for fewer than two individuals)
+    virtual double estimate(const std::vector<Individual<T>>& population) = 0;
+};
+
+// Exact mean Euclidean distance over all pairs of individuals and all centroids
+// O(P^2 * k * d) - the reference definition, expensive for large populations
+template <typename T>
+class PairwiseDiversity : public DiversityEstimator<T> {
+public:
+    double estimate(const std::vector<Individual<T>>& population) override;
+};
+
+// Root mean square pairwise distance computed from per-centroid variance
+// Uses mean ||x_i - x_j||^2 over pairs = 2P / (P - 1) * variance, so it runs in
+// O(P * k * d). The value is never below the exact mean pairwise distance
+// (it is its quadratic mean), so diversity thresholds may need retuning.
+template <typename T>
+class CentroidVarianceDiversity : public DiversityEstimator<T> {
+    std::vector<double> mean; // Per-centroid mean, reused between calls
+
+public:
+    double estimate(const std::vector<Individual<T>>& population) override;
+};
+
+// Unbiased estimate of the exact pairwise mean from randomly sampled pairs
+// Pairs are drawn until the 95% confidence half-width falls below
+// relative_error times the running mean, or max_pairs is reached.
+// Populations with at most max_pairs pairs are evaluated exactly.
+template <typename T>
+class SampledPairsDiversity : public DiversityEstimator<T> {
+    double relative_error; // Target relative error of the estimate
+    size_t min_pairs;      // Pairs drawn before the error is checked
+    size_t max_pairs;      // Upper bound on pairs per estimate
+    std::mt19937 rng;      // Own stream, so sampling does not perturb the GA
+    PairwiseDiversity<T> exact;
+
+public:
+    // Constructor
+    // error - target relative error of the estimate (e.g. 0.05 for 5%)
+    // max - maximum number of sampled pairs per estimate
+    // seed - seed of the sampling stream
+    SampledPairsDiversity(double error = 0.05, size_t max = 2000, unsigned int seed = 5489u)
+        : relative_error(error), min_pairs(32), max_pairs(max), rng(seed) {}
+
+    double estimate(const std::vector<Individual<T>>& population) override;
+};
+
+#include "DiversityEstimator.ipp"
@@ -0,0 +1,96 @@
+#include "DiversityEstimator.h"
+#include <cmath>
+
+// Mean distance between same-index centroids of two individuals
+template <typename T>
+double centroid_pair_distance(const Individual<T>& a, const Individual<T>& b) {
+    const size_t k = a.centroids.rows();
+    const size_t dim = a.centroids.dimension();
+    double total = 0.0;
+    for (size_t c = 0; c < k; ++c) {
+        total += std::sqrt(static_cast<double>(
+            DistanceKernels<T>::squared_distance(a.centroids.row(c), b.centroids.row(c), dim)));
+    }
+    return k > 0 ? total / static_cast<double>(k) : 0.0;
+}
+
+template <typename T>
+double PairwiseDiversity<T>::estimate(const std::vector<Individual<T>>& population) {
+    double total_distance = 0.0;
+    size_t count = 0;
+    
+    for (size_t i = 0; i < population.size(); ++i) {
+        for (size_t j = i + 1; j < population.size(); ++j) {
+            total_distance += centroid_pair_distance(population[i], population[j]);
+            count++;
+        }
+    }
+    
+    return count > 0 ? total_distance / (double)count : 0.0;
+}
+
+template <typename T>
+double CentroidVarianceDiversity<T>::estimate(const std::vector<Individual<T>>& population) {
+    const size_t p = population.size();
+    if (p < 2) return 0.0;
+
+    const size_t k = population[0].centroids.rows();
+    const size_t dim = population[0].centroids.dimension();
+    mean.assign(k * dim, 0.0);
+
+    for (const auto& individual : population) {
+        const T* coors = individual.centroids.data();
+        for (size_t i = 0; i < k * dim; ++i) {
+            mean[i] += static_cast<double>(coors[i]);
+        }
+    }
+    for (double& value : mean) {
+        value /= static_cast<double>(p);
+    }
+
+    double squared_deviation = 0.0;
+    for (const auto& individual : population) {
+        const T* coors = individual.centroids.data();
+        for (size_t i = 0; i < k * dim; ++i) {
+            const double diff = static_cast<double>(coors[i]) - mean[i];
+            squared_deviation += diff * diff;
+        }
+    }
+
+    // Mean squared pairwise distance per centroid slot
+    const double pair_mean_squared = 2.0 * squared_deviation
+        / (static_cast<double>(p - 1) * static_cast<double>(k));
+    return std::sqrt(pair_mean_squared);
+}
+
+template <typename T>
+double SampledPairsDiversity<T>::estimate(const std::vector<Individual<T>>& population) {
+    const size_t p = population.size();
+    if (p < 2) return 0.0;
+    if (p * (p - 1) / 2 <= max_pairs) return exact.estimate(population);
+
+    std::uniform_int_distribution<size_t> first(0, p - 1);
+    std::uniform_int_distribution<size_t> second(0, p - 2);
+
+    // Welford's running mean and variance of the sampled pair distances
+    double mean = 0.0;
+    double m2 = 0.0;
+    size_t n = 0;
+    while (n < max_pairs) {
+        const size_t i = first(rng);
+        size_t j = second(rng);
+        if (j >= i) ++j;
+
+        const double x = centroid_pair_distance(population[i], population[j]);
+        ++n;
+        const double delta = x - mean;
+        mean += delta / static_cast<double>(n);
+        m2 += delta * (x - mean);
+
+        if (n >= min_pairs) {
+            const double half_width = 1.96 * std::sqrt(m2 / static_cast<double>(n - 1) / static_cast<double>(n));
+            if (half_width <= relative_error * mean) break;
+        }
+    }
+    return mean;
+}
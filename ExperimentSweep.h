@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include "GeneticClustering.h"
+#include "Individual.h"
+#include "PointMatrix.h"
+#include "WorkStealingPool.h"
+
+// Grid of GeneticClustering parameters explored by a sweep
+// Every combination of the four vectors is run num_runs times
+struct ParameterGrid {
+    std::vector<size_t> clusters_k;
+    std::vector<size_t> population_sizes;
+    std::vector<double> crossover_rates;
+    std::vector<double> mutation_rates;
+
+    size_t num_runs = 10;            // Independent runs per combination
+    size_t max_generations = 100;    // Passed to the constructor and set_stop_conditions
+    size_t max_no_improvement = 20;
+    double diversity_threshold = 0.01;
+    double target_fitness = 0.0;
+};
+
+// One combination of grid parameters
+struct SweepConfig {
+    size_t k;
+    size_t population_size;
+    double crossover_rate;
+    double mutation_rate;
+};
+
+// Outcome of all runs of one configuration
+template <typename T>
+struct SweepResult {
+    SweepConfig config;
+    std::vector<double> run_wcss;   // WCSS of every run, in run order
+    double best_wcss;               // Lowest WCSS (earliest run wins ties)
+    Individual<T> best_solution;    // Best solution of the run with best_wcss
+};
+
+// Runs a parameter grid of independent GeneticClustering runs concurrently
+// on a work-stealing pool. All runs share one read-only copy of the dataset.
+// Every run gets a seed derived from the master seed and its position in
+// the grid, so results do not depend on the number of threads or on timing.
+// T - numeric type for point coordinates (e.g., double, float, int)
+template <typename T>
+class ExperimentSweep {
+private:
+    std::shared_ptr<const PointMatrix<T>> data; // Dataset shared by all runs
+    size_t num_threads;                         // Pool size (0 = all hardware threads)
+    unsigned int seed;                          // Master seed of the sweep
+
+    // Called after every finished run; invocations are serialized
+    std::function<void(const SweepConfig&, size_t run, double wcss)> on_run_finished;
+
+public:
+    // Parameters:
+    //   dataset - data to cluster, shared by all runs without copying
+    //   threads - number of worker threads (0 = all hardware threads)
+    ExperimentSweep(std::shared_ptr<const PointMatrix<T>> dataset, size_t threads = 0);
+
+    // Sets the master seed (by default taken from the clock)
+    void set_seed(unsigned int master_seed) { seed = master_seed; }
+
+    // Sets a callback invoked after every finished run (from a worker thread)
+    void set_progress_callback(std::function<void(const SweepConfig&, size_t, double)> callback);
+
+    // Expands the grid into configurations, ordered by k, population size,
+    // crossover rate and mutation rate (the nesting order of the old serial loops)
+    static std::vector<SweepConfig> expand(const ParameterGrid& grid);
+
+    // Runs every configuration of the grid and returns one result per
+    // configuration, in the order given by expand
+    std::vector<SweepResult<T>> run(const ParameterGrid& grid);
+};
+
+#include "ExperimentSweep.ipp"
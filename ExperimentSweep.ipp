@@ -0,0 +1,91 @@
+#include "ExperimentSweep.h"
+#include <chrono>
+#include <limits>
+
+template <typename T>
+ExperimentSweep<T>::ExperimentSweep(std::shared_ptr<const PointMatrix<T>> dataset, size_t threads)
+    : data(std::move(dataset)), num_threads(threads) {
+    seed = static_cast<unsigned int>(
+        std::chrono::system_clock::now().time_since_epoch().count()
+    );
+    if (data->layout() != Layout::RowMajor) {
+        data = std::make_shared<const PointMatrix<T>>(data->with_layout(Layout::RowMajor));
+    }
+}
+
+template <typename T>
+void ExperimentSweep<T>::set_progress_callback(std::function<void(const SweepConfig&, size_t, double)> callback) {
+    on_run_finished = std::move(callback);
+}
+
+template <typename T>
+std::vector<SweepConfig> ExperimentSweep<T>::expand(const ParameterGrid& grid) {
+    std::vector<SweepConfig> configs;
+    for (size_t k_c : grid.clusters_k) {
+        for (size_t pop_size : grid.population_sizes) {
+            for (double cross_rate : grid.crossover_rates) {
+                for (double mut_rate : grid.mutation_rates) {
+                    configs.push_back({k_c, pop_size, cross_rate, mut_rate});
+                }
+            }
+        }
+    }
+    return configs;
+}
+
+template <typename T>
+std::vector<SweepResult<T>> ExperimentSweep<T>::run(const ParameterGrid& grid) {
+    const std::vector<SweepConfig> configs = expand(grid);
+
+    std::vector<SweepResult<T>> results(configs.size());
+    std::vector<size_t> best_run(configs.size(), std::numeric_limits<size_t>::max());
+    for (size_t c = 0; c < configs.size(); ++c) {
+        results[c].config = configs[c];
+        results[c].run_wcss.assign(grid.num_runs, 0.0);
+        results[c].best_wcss = std::numeric_limits<double>::max();
+    }
+
+    // One lock per configuration guards its best solution
+    std::vector<std::mutex> result_locks(configs.size());
+    std::mutex callback_lock;
+
+    WorkStealingPool pool(num_threads);
+    for (size_t c = 0; c < configs.size(); ++c) {
+        for (size_t run = 0; run < grid.num_runs; ++run) {
+            pool.submit([&, c, run] {
+                const SweepConfig& config = configs[c];
+                std::seed_seq sequence{seed, static_cast<unsigned int>(c), static_cast<unsigned int>(run)};
+                unsigned int run_seed;
+                sequence.generate(&run_seed, &run_seed + 1);
+
+                GeneticClustering<T> gc(config.population_size, grid.max_generations,
+                                        config.crossover_rate, config.mutation_rate, config.k);
+                gc.set_stop_conditions(grid.max_generations, grid.max_no_improvement,
+                                       grid.diversity_threshold, grid.target_fitness);
+                gc.set_seed(run_seed);
+                gc.set_verbose(false);
+                gc.fit(data);
+
+                const double wcss = gc.getBestWCSS();
+                {
+                    std::lock_guard<std::mutex> lock(result_locks[c]);
+                    SweepResult<T>& result = results[c];
+                    result.run_wcss[run] = wcss;
+                    if (wcss < result.best_wcss || (wcss == result.best_wcss && run < best_run[c])) {
+                        result.best_wcss = wcss;
+                        result.best_solution = gc.get_best_solution();
+                        best_run[c] = run;
+                    }
+                }
+
+                if (on_run_finished) {
+                    std::lock_guard<std::mutex> lock(callback_lock);
+                    on_run_finished(config, run, wcss);
+                }
+            });
+        }
+    }
+    pool.wait();
+
+    return results;
+}
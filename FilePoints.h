@@ -5,7 +5,64 @@
 #include <fstream>
 #include <sstream>
 
+#include <cstdint>
+#include <future>
+#include <memory>
+
 #include "Point.h"
+#include "PointMatrix.h"
+#include "MappedFile.h"
+
+// Coordinate types of the binary point format
+enum class BinaryValueType : uint32_t { Float32 = 1, Float64 = 2, Int32 = 3, Int64 = 4 };
+
+// Header of the binary point format
+// The header is followed by rows x dim row-major coordinates at data_offset.
+// Values use the byte order of the machine that wrote them; byte_order lets
+// a reader detect a mismatch.
+struct BinaryPointsHeader {
+    char magic[8];          // "GCPOINTS"
+    uint32_t version;       // Format version, currently 1
+    uint32_t byte_order;    // 0x01020304 as written by the producer
+    uint32_t value_type;    // BinaryValueType of the coordinates
+    uint32_t value_size;    // Size of one coordinate in bytes
+    uint64_t rows;          // Number of points
+    uint64_t dim;           // Dimension of every point
+    uint64_t data_offset;   // Byte offset of the coordinates (64-byte aligned)
+};
+
+// Header of the binary clustering result format
+// The header is followed by `rows` uint32 labels at labels_offset and by
+// clusters x dim row-major centroid coordinates at centroids_offset (both
+// 64-byte aligned). Same byte order convention as BinaryPointsHeader.
+struct BinaryResultHeader {
+    char magic[8];              // "GCRESULT"
+    uint32_t version;           // Format version, currently 1
+    uint32_t byte_order;        // 0x01020304 as written by the producer
+    uint32_t value_type;        // BinaryValueType of the centroid coordinates
+    uint32_t value_size;        // Size of one coordinate in bytes
+    uint32_t label_size;        // Size of one label in bytes (4)
+    uint32_t reserved;          // 0
+    uint64_t rows;              // Number of labelled points
+    uint64_t dim;               // Dimension of the centroids
+    uint64_t clusters;          // Number of centroids
+    double wcss;                // Within-cluster sum of squares of the result
+    uint64_t labels_offset;     // Byte offset of the labels
+    uint64_t centroids_offset;  // Byte offset of the centroids
+};
+
+// Clustering result read from a binary result file
+// Labels point into the mapped file, which stays mapped while the result
+// (or a copy of it) exists. Centroids are a view of the file when they were
+// stored as T, and a converted copy otherwise.
+template <typename T>
+struct ClusterResult {
+    const uint32_t* labels = nullptr; // Cluster of every point
+    size_t rows = 0;                  // Number of labels
+    PointMatrix<T> centroids;         // One row per cluster
+    double wcss = 0.0;
+    std::shared_ptr<MappedFile> file; // Keeps the labels mapped
+};
 
 // A templated class for handling file operations related to Point data
 template <typename T>
@@ -14,16 +71,99 @@ class FilePoints {
         // Read a list of points from txt file
         static std::vector<Point<T>> readFromFile(std::string filename);
 
+        // Read points from txt file into contiguous row-major storage
+        // Coordinates may be separated by spaces, tabs, commas or semicolons.
+        // Header lines before the first row of numbers, empty lines and lines
+        // starting with '#' are skipped. The file is memory mapped and split
+        // into chunks parsed concurrently with std::from_chars.
+        // Parameters:
+        //   filename - text or CSV file
+        //   num_threads - number of parsing threads (0 = hardware concurrency)
+        // Throws:
+        //   std::runtime_error if the file cannot be read, a line after the
+        //   header is not numeric or lines have different numbers of coordinates
+        static PointMatrix<T> readMatrixFromFile(std::string filename, size_t num_threads = 1);
+
+        // Read points from a binary point file
+        // With memory_map the returned matrix is a zero-copy view of the mapped
+        // file, provided the stored type is T; otherwise values are converted
+        // into an owning matrix.
+        // Throws:
+        //   std::runtime_error if the file is not a valid binary point file
+        static PointMatrix<T> readBinaryFile(const std::string& filename, bool memory_map = true);
+
+        // Read a binary or text point file, detected from its first bytes
+        static PointMatrix<T> loadMatrix(const std::string& filename, size_t num_threads = 0);
+
+        // Write points to a binary point file storing coordinates of type T
+        static void writeBinaryFile(const PointMatrix<T>& points, const std::string& filename);
+
+        // Write points to a txt file, one point per line
+        // Values are written in their shortest form that reads back exactly
+        static void writeMatrixToFile(const PointMatrix<T>& points, const std::string& filename);
+
+        // Converters between the text and binary formats
+        static void convertTextToBinary(const std::string& text_file, const std::string& binary_file,
+                                        size_t num_threads = 0);
+        static void convertBinaryToText(const std::string& binary_file, const std::string& text_file);
+
         // Write to a txt file
         static void writeToFile(const std::vector<Point<T>> &points, std::string &filename);
 
         // Write points along with their cluster labels and centroids to a file
+        // Points are grouped by cluster in one pass over the labels (points
+        // with a label >= num_clusters are left out) and formatted like
+        // std::ostream with its default precision into a large buffer.
+        // Throws:
+        //   std::invalid_argument if there is not one label per point
+        //   std::runtime_error if the file cannot be written
         static void writeClustersWithLabels(const std::vector<Point<T>>& points, 
                                       const std::vector<size_t>& labels,
                                       const std::vector<Point<T>> &centroids,
                                       const size_t& num_clusters,
                                       const std::string& filename,
                                       const double WCSS);
+
+        // Same as above for contiguous point and centroid storage
+        static void writeClustersWithLabels(const PointMatrix<T>& points, 
+                                      const std::vector<size_t>& labels,
+                                      const PointMatrix<T> &centroids,
+                                      const size_t& num_clusters,
+                                      const std::string& filename,
+                                      const double WCSS);
+
+        // Runs writeClustersWithLabels on a background thread
+        // The task keeps the points alive and owns copies of the labels and
+        // centroids. Errors are rethrown by get() on the returned future.
+        static std::future<void> writeClustersWithLabelsAsync(std::shared_ptr<const PointMatrix<T>> points,
+                                                              std::vector<size_t> labels,
+                                                              PointMatrix<T> centroids,
+                                                              size_t num_clusters,
+                                                              std::string filename,
+                                                              double WCSS);
+
+        // Write labels, centroids and WCSS to a binary result file
+        // Throws:
+        //   std::invalid_argument if a label does not fit in 32 bits (nothing is written)
+        //   std::runtime_error if the file cannot be written
+        static void writeBinaryResult(const std::vector<size_t>& labels, const PointMatrix<T>& centroids,
+                                      const std::string& filename, double WCSS);
+
+        // Read a binary result file through a memory mapping
+        // Throws:
+        //   std::runtime_error if the file is not a valid binary result file
+        static ClusterResult<T> readBinaryResult(const std::string& filename);
+
+    private:
+        // Parses the numbers of the line starting at `cursor` into `values`
+        // and moves `cursor` past the end of the line
+        // Returns:
+        //   false if the line holds something that is not a number;
+        //   `count` receives the number of values (0 for blank and comment lines)
+        static bool parseLine(const char*& cursor, const char* end, std::vector<T>& values, size_t& count);
+
+        // Type tag of T in the binary format
+        static BinaryValueType binaryValueType();
 };
 
 #include "FilePoints.ipp"
\ No newline at end of file
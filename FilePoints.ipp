@@ -1,4 +1,11 @@
 #include "FilePoints.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <thread>
+#include <type_traits>
 
 using namespace std;
 
@@ -66,49 +73,524 @@ void FilePoints<T>::writeClustersWithLabels(const std::vector<Point<T>>& points,
                                       const size_t& num_clusters,
                                       const std::string& filename,
                                       const double WCSS) {
-        std::ofstream out(filename);
+    writeClustersWithLabels(PointMatrix<T>::from_points(points), labels,
+                            PointMatrix<T>::from_points(centroids), num_clusters, filename, WCSS);
+}
+
+template <typename T>
+bool FilePoints<T>::parseLine(const char*& cursor, const char* end, std::vector<T>& values, size_t& count) {
+    const auto is_separator = [](char c) {
+        return c == ' ' || c == '\t' || c == ',' || c == ';' || c == '\r';
+    };
+
+    const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+    if (line_end == nullptr) line_end = end;
+    const char* p = cursor;
+    cursor = line_end == end ? end : line_end + 1;
+    count = 0;
+
+    while (p < line_end && is_separator(*p)) ++p;
+    if (p < line_end && *p == '#') return true;
+
+    const size_t first = values.size();
+    while (p < line_end) {
+        if (*p == '+') ++p; // from_chars does not accept an explicit plus sign
+        T value;
+        const std::from_chars_result parsed = std::from_chars(p, line_end, value);
+        if (parsed.ec != std::errc() || (parsed.ptr < line_end && !is_separator(*parsed.ptr))) {
+            values.resize(first);
+            count = 0;
+            return false;
+        }
+        values.push_back(value);
+        ++count;
+        p = parsed.ptr;
+        while (p < line_end && is_separator(*p)) ++p;
+    }
+    return true;
+}
+
+template <typename T>
+PointMatrix<T> FilePoints<T>::readMatrixFromFile(string filename, size_t num_threads){
+    MappedFile file(filename);
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+
+    // Everything before the first line of numbers is header; the first
+    // line of numbers fixes the dimension
+    std::vector<T> first_row;
+    const char* data_begin = end;
+    size_t dim = 0;
+    for (const char* cursor = begin; cursor < end;) {
+        const char* line = cursor;
+        size_t count = 0;
+        if (parseLine(cursor, end, first_row, count) && count > 0) {
+            data_begin = line;
+            dim = count;
+            break;
+        }
+    }
+    if (dim == 0) return PointMatrix<T>();
+
+    // Split the rest at line boundaries, at least 1 MiB per thread
+    constexpr size_t min_chunk_bytes = size_t(1) << 20;
+    const size_t bytes = static_cast<size_t>(end - data_begin);
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunks = std::max<size_t>(1, std::min(num_threads, bytes / min_chunk_bytes));
+
+    std::vector<const char*> bounds;
+    bounds.reserve(chunks + 1);
+    bounds.push_back(data_begin);
+    for (size_t c = 1; c < chunks; ++c) {
+        const char* split = std::max(data_begin + bytes * c / chunks, bounds.back());
+        const char* newline = static_cast<const char*>(std::memchr(split, '\n', static_cast<size_t>(end - split)));
+        bounds.push_back(newline == nullptr ? end : newline + 1);
+    }
+    bounds.push_back(end);
+
+    std::vector<std::vector<T>> chunk_values(chunks);
+    auto parse = [&](size_t chunk) {
+        std::vector<T>& values = chunk_values[chunk];
+        const char* chunk_end = bounds[chunk + 1];
+        for (const char* cursor = bounds[chunk]; cursor < chunk_end;) {
+            const char* line = cursor;
+            size_t count = 0;
+            const bool numeric = parseLine(cursor, chunk_end, values, count);
+            if (numeric && (count == 0 || count == dim)) continue;
+
+            std::string text(line, cursor);
+            while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+            if (!numeric) {
+                throw runtime_error("Could not parse line: " + text);
+            }
+            throw runtime_error("Inconsistent number of coordinates in line: " + text);
+        }
+    };
+    ThreadPool pool(chunks);
+    pool.run(parse);
+
+    std::vector<size_t> offsets(chunks + 1, 0);
+    for (size_t c = 0; c < chunks; ++c) {
+        offsets[c + 1] = offsets[c] + chunk_values[c].size();
+    }
+    PointMatrix<T> points(offsets[chunks] / dim, dim);
+    auto gather = [&](size_t chunk) {
+        std::copy(chunk_values[chunk].begin(), chunk_values[chunk].end(), points.data() + offsets[chunk]);
+        std::vector<T>().swap(chunk_values[chunk]);
+    };
+    pool.run(gather);
+    return points;
+}
+
+template <typename T>
+BinaryValueType FilePoints<T>::binaryValueType() {
+    if constexpr (std::is_floating_point_v<T>) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Binary point files store 32 or 64-bit floats");
+        return sizeof(T) == 4 ? BinaryValueType::Float32 : BinaryValueType::Float64;
+    } else {
+        static_assert(std::is_integral_v<T> && std::is_signed_v<T> && (sizeof(T) == 4 || sizeof(T) == 8),
+                      "Binary point files store 32 or 64-bit signed integers");
+        return sizeof(T) == 4 ? BinaryValueType::Int32 : BinaryValueType::Int64;
+    }
+}
+
+template <typename T>
+PointMatrix<T> FilePoints<T>::readBinaryFile(const std::string& filename, bool memory_map) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+
+    BinaryPointsHeader header;
+    if (file->size() < sizeof(header)) {
+        throw std::runtime_error("Not a binary point file: " + filename);
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "GCPOINTS", sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a binary point file: " + filename);
+    }
+    if (header.version != 1) {
+        throw std::runtime_error("Unsupported binary point file version in: " + filename);
+    }
+    if (header.byte_order != 0x01020304) {
+        throw std::runtime_error("Binary point file was written with a different byte order: " + filename);
+    }
+
+    size_t value_size = 0;
+    switch (static_cast<BinaryValueType>(header.value_type)) {
+        case BinaryValueType::Float32: case BinaryValueType::Int32: value_size = 4; break;
+        case BinaryValueType::Float64: case BinaryValueType::Int64: value_size = 8; break;
+        default: throw std::runtime_error("Unknown coordinate type in: " + filename);
+    }
+    const size_t rows = static_cast<size_t>(header.rows);
+    const size_t dim = static_cast<size_t>(header.dim);
+    const size_t count = rows * dim;
+    if (header.value_size != value_size || (dim != 0 && count / dim != rows) ||
+        header.data_offset > file->size() || count > (file->size() - header.data_offset) / value_size) {
+        throw std::runtime_error("Truncated or corrupt binary point file: " + filename);
+    }
+
+    char* source = file->data() + header.data_offset;
+    const BinaryValueType type = static_cast<BinaryValueType>(header.value_type);
+    if (memory_map && type == binaryValueType() && header.data_offset % alignof(T) == 0) {
+        return PointMatrix<T>::view(reinterpret_cast<T*>(source), rows, dim, std::move(file));
+    }
+
+    PointMatrix<T> points(rows, dim);
+    auto convert = [&](auto stored) {
+        using Stored = decltype(stored);
+        for (size_t i = 0; i < count; ++i) {
+            std::memcpy(&stored, source + i * sizeof(Stored), sizeof(Stored));
+            points.data()[i] = static_cast<T>(stored);
+        }
+    };
+    switch (type) {
+        case BinaryValueType::Float32: convert(float()); break;
+        case BinaryValueType::Float64: convert(double()); break;
+        case BinaryValueType::Int32: convert(int32_t()); break;
+        case BinaryValueType::Int64: convert(int64_t()); break;
+    }
+    return points;
+}
+
+template <typename T>
+PointMatrix<T> FilePoints<T>::loadMatrix(const std::string& filename, size_t num_threads) {
+    char magic[8] = {};
+    {
+        std::ifstream in(filename, std::ios::binary);
+        if (!in.is_open()) {
+            throw std::runtime_error("Could not open the file: " + filename);
+        }
+        in.read(magic, sizeof(magic));
+    }
+    if (std::memcmp(magic, "GCPOINTS", sizeof(magic)) == 0) {
+        return readBinaryFile(filename);
+    }
+    return readMatrixFromFile(filename, num_threads);
+}
+
+template <typename T>
+void FilePoints<T>::writeBinaryFile(const PointMatrix<T>& points, const std::string& filename) {
+    static_assert(sizeof(BinaryPointsHeader) <= 64, "Header must fit before the coordinates");
+    constexpr size_t data_offset = 64;
+
+    PointMatrix<T> row_major;
+    const PointMatrix<T>* source = &points;
+    if (points.layout() != Layout::RowMajor) {
+        row_major = points.with_layout(Layout::RowMajor);
+        source = &row_major;
+    }
+
+    BinaryPointsHeader header;
+    std::memcpy(header.magic, "GCPOINTS", sizeof(header.magic));
+    header.version = 1;
+    header.byte_order = 0x01020304;
+    header.value_type = static_cast<uint32_t>(binaryValueType());
+    header.value_size = sizeof(T);
+    header.rows = source->rows();
+    header.dim = source->dimension();
+    header.data_offset = data_offset;
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    const char padding[data_offset] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(padding, data_offset - sizeof(header));
+    out.write(reinterpret_cast<const char*>(source->data()),
+              static_cast<std::streamsize>(source->rows() * source->dimension() * sizeof(T)));
+    if (!out.good()) {
+        throw std::runtime_error("Error while writing to file: " + filename);
+    }
+}
+
+template <typename T>
+void FilePoints<T>::writeMatrixToFile(const PointMatrix<T>& points, const std::string& filename) {
+    std::ofstream out(filename, std::ios::binary);
     if (!out) {
         throw std::runtime_error("Failed to open file: " + filename);
     }
 
-    try {
-        const size_t dim = points[0].dimension();
+    // Values are formatted into a buffer that is flushed in large blocks
+    constexpr size_t buffer_size = size_t(1) << 20;
+    constexpr size_t max_value_chars = 64;
+    std::vector<char> buffer(buffer_size);
+    size_t used = 0;
+    for (size_t i = 0; i < points.rows(); ++i) {
+        for (size_t j = 0; j < points.dimension(); ++j) {
+            if (used + max_value_chars > buffer_size) {
+                out.write(buffer.data(), static_cast<std::streamsize>(used));
+                used = 0;
+            }
+            if (j > 0) buffer[used++] = ' ';
+            const std::to_chars_result written =
+                std::to_chars(buffer.data() + used, buffer.data() + buffer_size, points(i, j));
+            used = static_cast<size_t>(written.ptr - buffer.data());
+        }
+        buffer[used++] = '\n';
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(used));
+    if (!out.good()) {
+        throw std::runtime_error("Error while writing to file: " + filename);
+    }
+}
 
-        out << "# Cluster grouping | Format: ";
+template <typename T>
+void FilePoints<T>::convertTextToBinary(const std::string& text_file, const std::string& binary_file,
+                                        size_t num_threads) {
+    writeBinaryFile(readMatrixFromFile(text_file, num_threads), binary_file);
+}
+
+template <typename T>
+void FilePoints<T>::convertBinaryToText(const std::string& binary_file, const std::string& text_file) {
+    writeMatrixToFile(readBinaryFile(binary_file), text_file);
+}
+
+template <typename T>
+void FilePoints<T>::writeClustersWithLabels(const PointMatrix<T>& points, 
+                                      const std::vector<size_t>& labels,
+                                      const PointMatrix<T> &centroids,
+                                      const size_t& num_clusters,
+                                      const std::string& filename,
+                                      const double WCSS) {
+    if (labels.size() != points.rows()) {
+        throw std::invalid_argument("Expected one label per point");
+    }
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    // Points are bucketed by label with a counting sort instead of scanning
+    // all points once per cluster
+    const size_t n = points.rows();
+    const size_t dim = points.dimension();
+    std::vector<size_t> cluster_start(num_clusters + 1, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (labels[i] < num_clusters) cluster_start[labels[i] + 1]++;
+    }
+    for (size_t c = 0; c < num_clusters; ++c) {
+        cluster_start[c + 1] += cluster_start[c];
+    }
+    std::vector<size_t> order(cluster_start[num_clusters]);
+    {
+        std::vector<size_t> next(cluster_start.begin(), cluster_start.end() - 1);
+        for (size_t i = 0; i < n; ++i) {
+            if (labels[i] < num_clusters) order[next[labels[i]]++] = i;
+        }
+    }
+
+    // Text is formatted into a buffer that is flushed in large blocks.
+    // Numbers look like std::ostream output with default flags: floating
+    // point values as %g with 6 significant digits
+    constexpr size_t buffer_size = size_t(1) << 20;
+    constexpr size_t max_value_chars = 64;
+    std::vector<char> buffer(buffer_size);
+    size_t used = 0;
+    auto reserve = [&](size_t chars) {
+        if (used + chars > buffer_size) {
+            out.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+    };
+    auto put_text = [&](const char* text) {
+        const size_t length = std::strlen(text);
+        reserve(length);
+        std::memcpy(buffer.data() + used, text, length);
+        used += length;
+    };
+    auto put_number = [&](auto value) {
+        reserve(max_value_chars);
+        std::to_chars_result written;
+        if constexpr (std::is_floating_point_v<decltype(value)>) {
+            written = std::to_chars(buffer.data() + used, buffer.data() + buffer_size, value,
+                                    std::chars_format::general, 6);
+        } else {
+            written = std::to_chars(buffer.data() + used, buffer.data() + buffer_size, value);
+        }
+        used = static_cast<size_t>(written.ptr - buffer.data());
+    };
+    auto put_row = [&](const T* coordinates, size_t stride) {
         for (size_t d = 0; d < dim; ++d) {
-            out << "coord" << d+1 << " ";
+            put_number(coordinates[d * stride]);
+            put_text(", ");
         }
-        out << "| cluster_id\n\n";
-        out << "WSCC is " << WCSS << "\n\n";
+    };
+    // Row i of a matrix in either layout starts at row(i) with this stride
+    auto stride_of = [](const PointMatrix<T>& matrix) {
+        return matrix.layout() == Layout::RowMajor ? size_t(1) : matrix.rows();
+    };
+    auto row_start = [](const PointMatrix<T>& matrix, size_t i) {
+        return matrix.layout() == Layout::RowMajor ? matrix.row(i) : matrix.data() + i;
+    };
 
-        for (size_t cluster = 0; cluster < num_clusters; ++cluster) {
-            out << "# Cluster " << cluster << "\n";
+    put_text("# Cluster grouping | Format: ");
+    for (size_t d = 0; d < dim; ++d) {
+        put_text("coord");
+        put_number(d + 1);
+        put_text(" ");
+    }
+    put_text("| cluster_id\n\nWSCC is ");
+    put_number(WCSS);
+    put_text("\n\n");
 
-            out << "Centroid: ";
-            for (size_t d = 0; d < dim; ++d) {
-                out << centroids[cluster].coors[d] << ", ";
-            }
-            out << "\n";
-            
-            for (size_t i = 0; i < points.size(); ++i) {
-                if (labels[i] == cluster) {
-                    for (size_t d = 0; d < dim; ++d) {
-                        out << points[i].coors[d] << ", ";
-                    }
-                    out << "\n";
-                }
-            }
-            out << "\n";  
+    const size_t point_stride = stride_of(points);
+    const size_t centroid_stride = stride_of(centroids);
+    for (size_t cluster = 0; cluster < num_clusters; ++cluster) {
+        put_text("# Cluster ");
+        put_number(cluster);
+        put_text("\nCentroid: ");
+        put_row(row_start(centroids, cluster), centroid_stride);
+        put_text("\n");
+        for (size_t p = cluster_start[cluster]; p < cluster_start[cluster + 1]; ++p) {
+            put_row(row_start(points, order[p]), point_stride);
+            put_text("\n");
         }
+        put_text("\n");
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(used));
 
-        if (!out.good()) {
-            throw std::runtime_error("Error during file writing");
+    if (!out.good()) {
+        throw std::runtime_error("Error during file writing");
+    }
+}
+
+template <typename T>
+std::future<void> FilePoints<T>::writeClustersWithLabelsAsync(std::shared_ptr<const PointMatrix<T>> points,
+                                                              std::vector<size_t> labels,
+                                                              PointMatrix<T> centroids,
+                                                              size_t num_clusters,
+                                                              std::string filename,
+                                                              double WCSS) {
+    return std::async(std::launch::async,
+        [points = std::move(points), labels = std::move(labels), centroids = std::move(centroids),
+         num_clusters, filename = std::move(filename), WCSS]() {
+            writeClustersWithLabels(*points, labels, centroids, num_clusters, filename, WCSS);
+        });
+}
+
+template <typename T>
+void FilePoints<T>::writeBinaryResult(const std::vector<size_t>& labels, const PointMatrix<T>& centroids,
+                                      const std::string& filename, double WCSS) {
+    static_assert(sizeof(BinaryResultHeader) <= 128, "Header must fit before the labels");
+    constexpr size_t alignment = 64;
+    constexpr size_t labels_offset = 128;
+    const size_t labels_bytes = labels.size() * sizeof(uint32_t);
+    const size_t centroids_offset = (labels_offset + labels_bytes + alignment - 1) / alignment * alignment;
+    // Checked before the file is opened, so a failure leaves no partial file
+    if (!labels.empty() && *std::max_element(labels.begin(), labels.end()) > UINT32_MAX) {
+        throw std::invalid_argument("Label does not fit in 32 bits");
+    }
+
+    PointMatrix<T> row_major;
+    const PointMatrix<T>* source = &centroids;
+    if (centroids.layout() != Layout::RowMajor) {
+        row_major = centroids.with_layout(Layout::RowMajor);
+        source = &row_major;
+    }
+
+    BinaryResultHeader header;
+    std::memcpy(header.magic, "GCRESULT", sizeof(header.magic));
+    header.version = 1;
+    header.byte_order = 0x01020304;
+    header.value_type = static_cast<uint32_t>(binaryValueType());
+    header.value_size = sizeof(T);
+    header.label_size = sizeof(uint32_t);
+    header.reserved = 0;
+    header.rows = labels.size();
+    header.dim = source->dimension();
+    header.clusters = source->rows();
+    header.wcss = WCSS;
+    header.labels_offset = labels_offset;
+    header.centroids_offset = centroids_offset;
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+    const char padding[labels_offset] = {};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(padding, labels_offset - sizeof(header));
+
+    // Labels are narrowed to 32 bits in blocks
+    constexpr size_t block_size = size_t(1) << 16;
+    std::vector<uint32_t> block(std::min(labels.size(), block_size));
+    for (size_t first = 0; first < labels.size(); first += block_size) {
+        const size_t count = std::min(block_size, labels.size() - first);
+        for (size_t i = 0; i < count; ++i) {
+            block[i] = static_cast<uint32_t>(labels[first + i]);
         }
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(count * sizeof(uint32_t)));
     }
-    catch (...) {
-        out.close();
-        throw;
+    out.write(padding, static_cast<std::streamsize>(centroids_offset - labels_offset - labels_bytes));
+    out.write(reinterpret_cast<const char*>(source->data()),
+              static_cast<std::streamsize>(source->rows() * source->dimension() * sizeof(T)));
+    if (!out.good()) {
+        throw std::runtime_error("Error while writing to file: " + filename);
     }
-    out.close();
 }
 
+template <typename T>
+ClusterResult<T> FilePoints<T>::readBinaryResult(const std::string& filename) {
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+
+    BinaryResultHeader header;
+    if (file->size() < sizeof(header)) {
+        throw std::runtime_error("Not a binary result file: " + filename);
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, "GCRESULT", sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a binary result file: " + filename);
+    }
+    if (header.version != 1) {
+        throw std::runtime_error("Unsupported binary result file version in: " + filename);
+    }
+    if (header.byte_order != 0x01020304) {
+        throw std::runtime_error("Binary result file was written with a different byte order: " + filename);
+    }
+
+    size_t value_size = 0;
+    switch (static_cast<BinaryValueType>(header.value_type)) {
+        case BinaryValueType::Float32: case BinaryValueType::Int32: value_size = 4; break;
+        case BinaryValueType::Float64: case BinaryValueType::Int64: value_size = 8; break;
+        default: throw std::runtime_error("Unknown coordinate type in: " + filename);
+    }
+    const size_t rows = static_cast<size_t>(header.rows);
+    const size_t dim = static_cast<size_t>(header.dim);
+    const size_t clusters = static_cast<size_t>(header.clusters);
+    const size_t count = clusters * dim;
+    const size_t size = file->size();
+    if (header.value_size != value_size || header.label_size != sizeof(uint32_t) ||
+        (dim != 0 && count / dim != clusters) ||
+        header.labels_offset % alignof(uint32_t) != 0 || header.labels_offset > size ||
+        rows > (size - header.labels_offset) / sizeof(uint32_t) ||
+        header.centroids_offset > size || count > (size - header.centroids_offset) / value_size) {
+        throw std::runtime_error("Truncated or corrupt binary result file: " + filename);
+    }
+
+    ClusterResult<T> result;
+    result.labels = reinterpret_cast<const uint32_t*>(file->data() + header.labels_offset);
+    result.rows = rows;
+    result.wcss = header.wcss;
+
+    char* source = file->data() + header.centroids_offset;
+    const BinaryValueType type = static_cast<BinaryValueType>(header.value_type);
+    if (type == binaryValueType() && header.centroids_offset % alignof(T) == 0) {
+        result.centroids = PointMatrix<T>::view(reinterpret_cast<T*>(source), clusters, dim, file);
+    } else {
+        result.centroids.resize(clusters, dim);
+        auto convert = [&](auto stored) {
+            using Stored = decltype(stored);
+            for (size_t i = 0; i < count; ++i) {
+                std::memcpy(&stored, source + i * sizeof(Stored), sizeof(Stored));
+                result.centroids.data()[i] = static_cast<T>(stored);
+            }
+        };
+        switch (type) {
+            case BinaryValueType::Float32: convert(float()); break;
+            case BinaryValueType::Float64: convert(double()); break;
+            case BinaryValueType::Int32: convert(int32_t()); break;
+            case BinaryValueType::Int64: convert(int64_t()); break;
+        }
+    }
+    result.file = std::move(file);
+    return result;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+// Bounded map from centroid hashes to fitness values
+// Direct-mapped: every key has a single slot and a newer entry overwrites an
+// older one, so memory stays fixed at the capacity given to the constructor.
+// Safe to use from several threads at once.
+class FitnessCache {
+public:
+    // Creates a cache with `capacity` slots (at least 1)
+    explicit FitnessCache(size_t capacity);
+
+    // Looks up a hash; on a hit stores the fitness and returns true
+    bool lookup(uint64_t key, double& fitness) const;
+
+    // Stores the fitness of a hash, replacing whatever occupied its slot
+    void store(uint64_t key, double fitness);
+
+    // Removes all entries
+    void clear();
+
+    size_t capacity() const { return slots.size(); }
+
+private:
+    struct Slot {
+        uint64_t key = 0;
+        double fitness = 0.0;
+        bool used = false;
+    };
+
+    std::vector<Slot> slots;
+    mutable std::mutex mutex;
+};
+
+#include "FitnessCache.ipp"
@@ -0,0 +1,25 @@
+#include "FitnessCache.h"
+#include <algorithm>
+
+inline FitnessCache::FitnessCache(size_t capacity) : slots(std::max<size_t>(capacity, 1)) {}
+
+inline bool FitnessCache::lookup(uint64_t key, double& fitness) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Slot& slot = slots[key % slots.size()];
+    if (!slot.used || slot.key != key) return false;
+    fitness = slot.fitness;
+    return true;
+}
+
+inline void FitnessCache::store(uint64_t key, double fitness) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Slot& slot = slots[key % slots.size()];
+    slot.key = key;
+    slot.fitness = fitness;
+    slot.used = true;
+}
+
+inline void FitnessCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fill(slots.begin(), slots.end(), Slot());
+}
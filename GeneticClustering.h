@@ -2,9 +2,38 @@
 #include <vector>
 #include <random>
 #include <memory>
+#include <string>
+#include <cstdint>
 #include "Individual.h"
 #include "Point.h"
+#include "PointMatrix.h"
 #include "MutationOperator.h"
+#include "ThreadPool.h"
+#include "DiversityEstimator.h"
+#include "FitnessCache.h"
+#include "Telemetry.h"
+#include <atomic>
+
+// Fitness evaluation counters of the last fit
+struct EvaluationStats {
+    size_t computed = 0;      // Individuals whose labels and fitness were computed
+    size_t skipped_clean = 0; // Children left unchanged by crossover and mutation
+    size_t cache_hits = 0;    // Children whose centroids were found in the fitness cache
+};
+
+// How mini-batches are drawn from the data
+// Reservoir  - uniform sample of the rows
+// Stratified - proportional sample from every cluster of the current elite
+//              (uniform for the first batch, before an elite exists)
+enum class SamplingStrategy { Reservoir, Stratified };
+
+// Individuals that receive Lloyd (k-means) refinement steps in memetic mode
+enum class MemeticTarget { None, Elite, Offspring, Both };
+
+// Starting point of partial_fit on a grown dataset
+// Population    - the current population continues evolving
+// BestCentroids - the best individual is kept and the rest is re-initialized
+enum class WarmStart { Population, BestCentroids };
 
 // Genetic Algorithm for Clustering Problems
 // T - numeric type for point coordinates (e.g., double, float, int)
@@ -24,22 +53,96 @@ private:
     double target_fitness;      // Target fitness value for early stopping
 
     // Algorithm state
-    std::vector<Point<T>> data; // Input data to be clustered
-    std::vector<Individual<T>> population; // Current population of solutions
+    std::shared_ptr<const PointMatrix<T>> data; // Input data to be clustered (row-major, read-only)
+    std::shared_ptr<PointMatrix<T>> owned_data; // Same as data once partial_fit owns it, else null
+    std::vector<Individual<T>> population;      // Current population of solutions
+    std::vector<Individual<T>> next_population; // Offspring buffer, swapped with population each generation
+    Individual<T> spare_child;                  // Receives the unused second child of the last pair
     std::mt19937 rng;           // Mersenne Twister random number generator
+    unsigned int seed;          // Master seed of rng and of the worker streams
+
+    // Parallel evaluation
+    size_t num_threads;         // Workers used by fit (1 = serial)
+    std::unique_ptr<ThreadPool> pool;        // Created by fit when num_threads > 1
+    std::vector<std::mt19937> worker_rngs;   // One stream per worker, derived from seed
+
+    bool verbose;               // Print progress to std::cout
+    bool incremental_assignment; // Reuse parent label bounds when assigning children
+    static constexpr size_t no_donor = static_cast<size_t>(-1);
+    std::vector<size_t> bounds_donor; // Per offspring slot: unchanged parent whose labels and bounds it takes
+    std::vector<size_t> donor_holder; // Per parent: slot that took its buffers in this generation
+
+    // Fitness memoization
+    std::unique_ptr<FitnessCache> fitness_cache; // Optional cache keyed by centroid hash
+    std::atomic<size_t> evaluations_computed{0};
+    std::atomic<size_t> evaluations_skipped{0};
+    std::atomic<size_t> evaluations_cached{0};
+
+    // Mini-batch evaluation
+    size_t batch_size;          // Points per mini-batch (0 = score on the full data)
+    SamplingStrategy sampling;  // How batches are drawn
+    size_t resample_interval;   // Generations between batch re-draws (0 = keep the first)
+    PointMatrix<T> batch;       // Copies of the sampled rows of data
+    std::vector<size_t> batch_rows;     // Indices of the sampled rows (scratch)
+    std::vector<size_t> stratum_counts; // Per-cluster row and quota counts (scratch)
+    const PointMatrix<T>* fitness_data; // Points offspring are scored on (data or batch)
+    double fitness_scale;       // data rows / fitness_data rows
+
+    // Memetic refinement
+    MemeticTarget memetic_target; // Who gets Lloyd steps (None = plain GA)
+    size_t lloyd_steps;           // Maximum Lloyd iterations per refinement
+    double lloyd_tolerance;       // Stop once no centroid moves farther than this
+
+    // Streaming
+    double decay;               // Weight multiplier of existing points when a batch is appended
+    size_t reserved_points;     // Capacity requested by reserve_points
+    std::vector<size_t> segment_starts; // First row of every appended batch
+    std::vector<double> segment_weights; // Fitness weight of the points of every batch
+    size_t resume_rows;         // Rows covered by a loaded checkpoint (until the data is given)
+    static constexpr char checkpoint_magic[8] = {'G', 'C', 'C', 'H', 'K', 'P', 'T', '\0'};
+    static constexpr uint64_t checkpoint_version = 1;
+
+    // Telemetry
+    FitObserver* observer;        // Receives per-generation telemetry (nullptr = off)
+    std::vector<PhaseTimes> worker_times; // Phase times of the current generation, per worker
+    std::atomic<size_t> distance_evaluations{0};
 
     MutationOperator<T>* mutation_op; // Pointer to mutation strategy
+    DiversityEstimator<T>* diversity_estimator; // Pointer to diversity strategy
+    // Diversity of the current population, estimated at most once per
+    // generation: by the run loop when it needs it, else on first request
+    mutable double current_diversity;
+    mutable bool diversity_estimated; // current_diversity belongs to the current population
 
     // Internal helper methods
-    double compute_fitness(Individual<T>& individual); // Evaluates solution quality
-    Individual<T> tournament_selection(size_t tournament_size); // Selects parents via tournament
-    void crossover(Individual<T>& parent1, Individual<T>& parent2, 
-                  Individual<T>& child1, Individual<T>& child2); // Creates offspring
-    void mutate(Individual<T>& individual); // Applies mutation to an individual
+    // Helpers taking a generator draw from it instead of rng, so workers can
+    // run them concurrently on their own streams
+    double compute_fitness(Individual<T>& individual,
+                           const Individual<T>* parent = nullptr); // Evaluates solution quality
+    size_t tournament_selection(size_t tournament_size,
+                                std::mt19937& generator) const; // Selects a parent index via tournament
+    void crossover(Individual<T>& child1, Individual<T>& child2,
+                  std::mt19937& generator); // Recombines two children holding copies of their parents
+    void mutate(Individual<T>& individual, std::mt19937& generator); // Applies mutation to an individual
+    void evaluate(Individual<T>& child, const Individual<T>& parent); // Evaluates a child unless unchanged
+    void settle_borrowed_bounds(); // Hands parent labels and bounds to their unchanged children
+    void score_full(Individual<T>& individual); // Fitness and labels on the full data
+    void draw_batch(const Individual<T>* elite); // Samples a new mini-batch (elite gives the strata)
+    void refine(Individual<T>& individual, const PointMatrix<T>& points); // Applies Lloyd steps on points
+    bool weighted() const; // True when batches have different weights
+    double assign_weighted(Individual<T>& individual); // Labels all points, returns the weighted fitness
+    void append_data(const PointMatrix<T>& new_points); // Appends to owned_data, copying shared data once
+    void rescore_population(size_t old_rows, WarmStart mode); // Brings the population up to the grown data
+    void run(size_t generations, bool warm_start, size_t old_rows = 0,
+             WarmStart mode = WarmStart::Population); // Initializes or resumes, then evolves
+    void breed(size_t first_pair, size_t last_pair, std::mt19937& generator,
+               PhaseTimes* times); // Fills the next_population slots of a pair range (times may be null)
+    void prepare_workers(bool keep_streams = false); // Creates the thread pool and worker streams for fit
     bool is_converged() const; // Checks if population has converged
-    bool should_stop(size_t generation, size_t no_improvement_count, 
+    bool should_stop(size_t generation, size_t generations, size_t no_improvement_count,
                     double current_best_fitness) const; // Determines stopping condition
     double calculate_diversity() const; // Computes population diversity metric
+    double cached_diversity() const; // current_diversity, estimated first if needed
 
 public:
     // Constructor - initializes core parameters
@@ -61,26 +164,143 @@ public:
     void set_stop_conditions(size_t max_gen, size_t max_no_imp,
                            double diversity_thresh, double target_fit);
 
+    // Sets the master seed (by default taken from the clock)
+    // Results are reproducible for a given seed and number of threads
+    void set_seed(unsigned int master_seed);
+    unsigned int get_seed() const { return seed; }
+
+    // Sets the number of threads used to build and evaluate offspring
+    // 1 (default) runs serially, 0 uses all hardware threads
+    void set_num_threads(size_t threads);
+    size_t get_num_threads() const { return num_threads; }
+
+    // Enables assignment of children from their parents' labels and distance
+    // bounds, re-examining only points the moved centroids may affect
+    // An option for large k * dim, not a general speedup: every point still
+    // costs some bookkeeping, which outweighs the saved distances when k * dim
+    // is small (it is slower there), and mutation moves most centroids a
+    // little, so only a few times fewer distances are computed. Costs two
+    // doubles of extra memory per point and individual. Disabled by default.
+    void set_incremental_assignment(bool enabled) { incremental_assignment = enabled; }
+
+    // Enables a bounded cache of fitness values keyed by centroid hash
+    // (0 disables it, the default). A hit skips the evaluation and leaves the
+    // labels stale until they are needed. Not used with incremental assignment,
+    // which needs the labels of every individual.
+    void set_fitness_cache(size_t capacity);
+
+    // Scores offspring on a sample of sample_size points instead of all data
+    // Fitness is the batch estimate scaled by rows / sample_size. The elite of
+    // every generation and the final population are scored on the full data,
+    // so get_best_solution and getBestWCSS are exact. A new batch is drawn
+    // every resample_interval generations (0 = never), which also clears the
+    // fitness cache and the incremental assignment bounds.
+    // sample_size 0 (the default) or >= the number of points disables it.
+    void set_minibatch(size_t sample_size, SamplingStrategy strategy = SamplingStrategy::Reservoir,
+                       size_t interval = 1);
+
+    // Enables memetic mode: Lloyd iterations (update_centroids + update_labels)
+    // are applied to the elite of every generation, to every offspring, or to
+    // both, after the usual evaluation. Refinement stops after `steps`
+    // iterations or once no centroid moves farther than `tolerance`.
+    // A refined elite is kept only if its fitness did not drop (Lloyd
+    // minimizes WCSS, fitness uses plain distances). Each label pass counts
+    // as a computed evaluation. MemeticTarget::None (the default) disables it.
+    void set_memetic(MemeticTarget target, size_t steps = 1, double tolerance = 0.0);
+
+    // Counts of computed and skipped evaluations during the last fit
+    EvaluationStats get_evaluation_stats() const;
+
+    // Enables or disables progress output to std::cout (enabled by default)
+    void set_verbose(bool enabled) { verbose = enabled; }
+
+    // Replaces the diversity estimator used by the convergence check and logging
+    // Takes ownership of the estimator (default: exact PairwiseDiversity)
+    void set_diversity_estimator(DiversityEstimator<T>* estimator);
+
+    // Sends per-generation telemetry (phase times, evaluation and allocation
+    // counts, throughput) to an observer such as JsonObserver or CsvObserver
+    // Takes ownership of the observer; nullptr (the default) turns telemetry
+    // off, in which case no clock is read.
+    void set_observer(FitObserver* fit_observer);
+
     // Main training method - runs clustering on input data
     // Parameters:
-    //   input_data - dataset to cluster (vector of Points)
+    //   input_data - dataset to cluster (converted to row-major if needed)
+    void fit(const PointMatrix<T>& input_data);
+
+    // Runs clustering on a dataset shared with other instances without copying it
+    // (row-major input is used as is; the data must not change during fit)
+    void fit(std::shared_ptr<const PointMatrix<T>> shared_data);
+
+    // Compatibility overload for a vector of Points
     void fit(const std::vector<Point<T>>& input_data);
 
+    // Appends a batch of points and continues evolution on the grown data
+    // Without a population this is a cold fit on the batch. Otherwise only
+    // the new points are labelled for every individual (fitness of the old
+    // points is carried over, scaled by the decay) before evolution resumes.
+    // After load_checkpoint the batch must hold all points so far; rows
+    // beyond those recorded in the checkpoint count as a new batch.
+    // Data passed to fit is copied once, on the first append.
+    // Parameters:
+    //   new_points - points to append (same dimension as the data so far)
+    //   mode - resume from the population or from its best individual
+    //   generations - generations to run (0 = max_generations)
+    // Throws:
+    //   std::invalid_argument if the dimension does not match
+    void partial_fit(const PointMatrix<T>& new_points, WarmStart mode = WarmStart::Population,
+                     size_t generations = 0);
+
+    // Weight multiplier applied to all existing points whenever partial_fit
+    // appends a batch, in (0, 1] (1, the default, keeps every point equal)
+    // Fitness becomes the weighted sum of distances; while weights differ,
+    // offspring are scored on the full data (mini-batch and incremental
+    // assignment are not used). WCSS stays unweighted.
+    void set_decay(double factor);
+
+    // Preallocates room for `total_points` so appends do not copy the data
+    void reserve_points(size_t total_points);
+
+    // Saves the population (centroids and fitness), the random number
+    // generator states and the batch weights to a binary file
+    // Labels are not saved; they are recomputed from the data on resume.
+    // Throws:
+    //   std::runtime_error if there is no population or the file cannot be written
+    void save_checkpoint(const std::string& filename) const;
+
+    // Restores a checkpoint written by save_checkpoint (the population size
+    // is taken from the file); the next partial_fit resumes from it
+    // The data is not saved: until that partial_fit, get_best_solution,
+    // computeWCSS and getBestWCSS throw std::runtime_error.
+    // Throws:
+    //   std::runtime_error if the file is missing, corrupt, or was written
+    //   for a different coordinate type or number of clusters
+    void load_checkpoint(const std::string& filename);
+
     // Returns the best solution found
+    // Throws:
+    //   std::runtime_error if there is no data (a checkpoint was loaded, but not resumed)
     Individual<T> get_best_solution() const;
 
     // Get WCSS
+    // Throws:
+    //   std::runtime_error if there is no data (a checkpoint was loaded, but not resumed)
     double computeWCSS(const Individual<T>& individual) const;
 
     // Receving method WCSS the best solution
+    // Throws:
+    //   std::runtime_error if there is no data (a checkpoint was loaded, but not resumed)
     double getBestWCSS() const;
 
     // Monitoring methods
     size_t get_current_generation() const { return current_generation; }
-    double get_current_diversity() const { return calculate_diversity(); }
+    // Diversity of the current generation; estimated on the first call if
+    // the generation did not need an estimate itself
+    double get_current_diversity() const { return cached_diversity(); }
 
-    // Destructor - cleans up mutation operator
-    ~GeneticClustering() { delete mutation_op; }
+    // Destructor - cleans up mutation operator, diversity estimator and observer
+    ~GeneticClustering() { delete mutation_op; delete diversity_estimator; delete observer; }
 
 private:
     size_t current_generation = 0; // Tracks current generation number
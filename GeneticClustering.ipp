@@ -5,14 +5,24 @@
 #include <limits>
 #include <iostream>
 #include <chrono>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <stdexcept>
 
 template <typename T>
 GeneticClustering<T>::GeneticClustering(size_t pop_size, size_t generations, 
                                       double cross_rate, double mut_rate, size_t clusters)
     : population_size(pop_size), max_generations(generations),
       crossover_rate(cross_rate), mutation_rate(mut_rate), k(clusters),
-      max_no_improvement(20), diversity_threshold(0.01), target_fitness(0.95) {
-    auto seed = static_cast<unsigned int>(
+      max_no_improvement(20), diversity_threshold(0.01), target_fitness(0.95),
+      num_threads(1), verbose(true), incremental_assignment(false),
+      batch_size(0), sampling(SamplingStrategy::Reservoir), resample_interval(1),
+      fitness_data(nullptr), fitness_scale(1.0),
+      memetic_target(MemeticTarget::None), lloyd_steps(1), lloyd_tolerance(0.0),
+      decay(1.0), reserved_points(0), resume_rows(0),
+      observer(nullptr), current_diversity(0.0), diversity_estimated(false) {
+    seed = static_cast<unsigned int>(
         std::chrono::system_clock::now().time_since_epoch().count()
     );
     rng.seed(seed);
@@ -23,6 +33,7 @@ GeneticClustering<T>::GeneticClustering(size_t pop_size, size_t generations,
     } else {
         mutation_op = new GaussianMutation<T>(mutation_rate, 0.1);
     } 
+    diversity_estimator = new PairwiseDiversity<T>();
 }
 
 template <typename T>
@@ -34,64 +45,331 @@ void GeneticClustering<T>::set_stop_conditions(size_t max_gen, size_t max_no_imp
     target_fitness = target_fit;
 }
 
+template <typename T>
+void GeneticClustering<T>::set_diversity_estimator(DiversityEstimator<T>* estimator) {
+    delete diversity_estimator;
+    diversity_estimator = estimator;
+    diversity_estimated = false;
+}
+
+template <typename T>
+void GeneticClustering<T>::set_observer(FitObserver* fit_observer) {
+    delete observer;
+    observer = fit_observer;
+}
+
+template <typename T>
+void GeneticClustering<T>::set_fitness_cache(size_t capacity) {
+    if (capacity == 0) {
+        fitness_cache.reset();
+    } else {
+        fitness_cache = std::make_unique<FitnessCache>(capacity);
+    }
+}
+
+template <typename T>
+void GeneticClustering<T>::set_minibatch(size_t sample_size, SamplingStrategy strategy, size_t interval) {
+    batch_size = sample_size;
+    sampling = strategy;
+    resample_interval = interval;
+}
+
+template <typename T>
+void GeneticClustering<T>::set_memetic(MemeticTarget target, size_t steps, double tolerance) {
+    memetic_target = target;
+    lloyd_steps = steps;
+    lloyd_tolerance = tolerance;
+}
+
+template <typename T>
+void GeneticClustering<T>::set_decay(double factor) {
+    if (!(factor > 0.0 && factor <= 1.0)) {
+        throw std::invalid_argument("Decay must be in (0, 1]");
+    }
+    decay = factor;
+}
+
+template <typename T>
+void GeneticClustering<T>::reserve_points(size_t total_points) {
+    reserved_points = total_points;
+    if (owned_data) owned_data->reserve(total_points);
+}
+
+template <typename T>
+EvaluationStats GeneticClustering<T>::get_evaluation_stats() const {
+    EvaluationStats stats;
+    stats.computed = evaluations_computed.load();
+    stats.skipped_clean = evaluations_skipped.load();
+    stats.cache_hits = evaluations_cached.load();
+    return stats;
+}
+
+template <typename T>
+void GeneticClustering<T>::set_seed(unsigned int master_seed) {
+    seed = master_seed;
+    rng.seed(seed);
+}
+
+template <typename T>
+void GeneticClustering<T>::set_num_threads(size_t threads) {
+    num_threads = threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threads;
+}
+
+template <typename T>
+void GeneticClustering<T>::prepare_workers(bool keep_streams) {
+    if (num_threads <= 1) {
+        pool.reset();
+        worker_rngs.clear();
+        return;
+    }
+    if (!pool || pool->size() != num_threads) {
+        pool = std::make_unique<ThreadPool>(num_threads);
+    }
+    if (keep_streams && worker_rngs.size() == num_threads) return;
+
+    // Worker w always gets the same stream for a given seed
+    worker_rngs.resize(num_threads);
+    for (size_t w = 0; w < num_threads; ++w) {
+        std::seed_seq sequence{seed, static_cast<unsigned int>(w)};
+        worker_rngs[w].seed(sequence);
+    }
+}
+
 template <typename T>
 void GeneticClustering<T>::fit(const std::vector<Point<T>>& input_data) {
-    data = input_data;
-    population.resize(population_size);
+    fit(PointMatrix<T>::from_points(input_data));
+}
+
+template <typename T>
+void GeneticClustering<T>::fit(const PointMatrix<T>& input_data) {
+    fit(std::make_shared<const PointMatrix<T>>(input_data.with_layout(Layout::RowMajor)));
+}
+
+template <typename T>
+void GeneticClustering<T>::fit(std::shared_ptr<const PointMatrix<T>> shared_data) {
+    if (shared_data->layout() != Layout::RowMajor) {
+        shared_data = std::make_shared<const PointMatrix<T>>(shared_data->with_layout(Layout::RowMajor));
+    }
+    data = std::move(shared_data);
+    owned_data.reset();
+    segment_starts.assign(1, 0);
+    segment_weights.assign(1, 1.0);
+    run(max_generations, false);
+}
+
+template <typename T>
+void GeneticClustering<T>::partial_fit(const PointMatrix<T>& new_points, WarmStart mode, size_t generations) {
+    if (generations == 0) generations = max_generations;
+
+    if (population.empty()) {
+        // Nothing to resume: a cold fit on the first batch
+        data.reset();
+        owned_data.reset();
+        append_data(new_points);
+        segment_starts.assign(1, 0);
+        segment_weights.assign(1, 1.0);
+        run(generations, false);
+        return;
+    }
+    if (new_points.dimension() != population[0].centroids.dimension()) {
+        throw std::invalid_argument("Points must have the dimension of the centroids");
+    }
+
+    if (!data) {
+        // Resuming a checkpoint: the points are the data seen so far, plus
+        // possibly a new batch. Labels were not saved, so every individual
+        // is scored from scratch.
+        append_data(new_points);
+        if (resume_rows == 0 || resume_rows > data->rows() || segment_starts.empty()) {
+            segment_starts.assign(1, 0);
+            segment_weights.assign(1, 1.0);
+        } else if (resume_rows < data->rows() && decay < 1.0) {
+            for (double& weight : segment_weights) weight *= decay;
+            segment_starts.push_back(resume_rows);
+            segment_weights.push_back(1.0);
+        }
+        resume_rows = 0;
+        run(generations, true, 0, mode);
+        return;
+    }
+
+    const size_t old_rows = data->rows();
+    append_data(new_points);
+    if (data->rows() > old_rows && decay < 1.0) {
+        // Older batches lose weight; equal weights need no segments
+        for (double& weight : segment_weights) weight *= decay;
+        segment_starts.push_back(old_rows);
+        segment_weights.push_back(1.0);
+    }
+    run(generations, true, old_rows, mode);
+}
+
+template <typename T>
+void GeneticClustering<T>::append_data(const PointMatrix<T>& new_points) {
+    if (data && new_points.dimension() != data->dimension() && !new_points.empty()) {
+        throw std::invalid_argument("Appended points must have the same dimension");
+    }
+    if (!owned_data) {
+        // Data given to fit may be shared with the caller: copy it once
+        const size_t dim = data ? data->dimension() : new_points.dimension();
+        const size_t rows = (data ? data->rows() : 0) + new_points.rows();
+        auto copy = std::make_shared<PointMatrix<T>>(0, dim);
+        copy->reserve(std::max(reserved_points, rows));
+        if (data) copy->append_rows(*data);
+        owned_data = std::move(copy);
+    }
+    if (new_points.layout() != Layout::RowMajor) {
+        owned_data->append_rows(new_points.with_layout(Layout::RowMajor));
+    } else {
+        owned_data->append_rows(new_points);
+    }
+    data = owned_data;
+}
+
+template <typename T>
+void GeneticClustering<T>::run(size_t generations, bool warm_start, size_t old_rows, WarmStart mode) {
+    const auto fit_start = std::chrono::steady_clock::now();
     current_generation = 0;
+    current_diversity = 0.0;
+    diversity_estimated = false;
+    evaluations_computed = 0;
+    evaluations_skipped = 0;
+    evaluations_cached = 0;
+    distance_evaluations = 0;
+    if (fitness_cache) fitness_cache->clear();
+    prepare_workers(warm_start);
+
+    // Telemetry: worker 0 also collects the serial parts of a generation
+    GenerationStats totals;
+    worker_times.assign(std::max<size_t>(num_threads, 1), PhaseTimes());
+    PhaseTimes* main_times = observer ? &worker_times[0] : nullptr;
+    const size_t allocations_at_start = allocation_count().load();
+
+    // Offspring are scored on a mini-batch only if it is smaller than the data
+    // (and all points weigh the same)
+    const bool minibatch = !weighted() && batch_size > 0 && batch_size < data->rows();
+    if (minibatch) {
+        draw_batch(nullptr);
+    } else {
+        fitness_data = data.get();
+        fitness_scale = 1.0;
+    }
+
+    // Both population buffers get their centroid and label storage up front;
+    // generations only copy into it, so the loop does not allocate
+    if (!warm_start) population.assign(population_size, Individual<T>());
+    next_population.assign(population_size, Individual<T>());
+    for (auto& individual : next_population) {
+        individual.centroids.resize(k, data->dimension());
+        individual.labels.resize(data->rows());
+        if (incremental_assignment) {
+            individual.distances.reserve(data->rows());
+            individual.lower_bounds.reserve(data->rows());
+        }
+    }
+    spare_child.centroids.resize(k, data->dimension());
+    bounds_donor.assign(population_size, no_donor);
+    donor_holder.assign(population_size, no_donor);
     
     // Population initialize
-    for (auto& individual : population) {
-        individual.initialize(k, data, rng);
-        individual.fitness = compute_fitness(individual);
+    if (warm_start) {
+        PhaseTimer timer(main_times, Phase::Fitness);
+        rescore_population(old_rows, mode);
+    } else if (pool) {
+        auto initialize_chunk = [&](size_t worker) {
+            PhaseTimer timer(observer ? &worker_times[worker] : nullptr, Phase::Fitness);
+            const size_t first = worker * population_size / num_threads;
+            const size_t last = (worker + 1) * population_size / num_threads;
+            for (size_t i = first; i < last; ++i) {
+                population[i].initialize(k, *data, worker_rngs[worker]);
+                population[i].fitness = compute_fitness(population[i]);
+            }
+        };
+        pool->run(initialize_chunk);
+    } else {
+        PhaseTimer timer(main_times, Phase::Fitness);
+        for (auto& individual : population) {
+            individual.initialize(k, *data, rng);
+            individual.fitness = compute_fitness(individual);
+        }
     }
+    // The initial population counts towards the totals only
+    for (auto& times : worker_times) {
+        totals.phases += times;
+        times = PhaseTimes();
+    }
+    size_t evaluations_before = evaluations_computed.load();
+    size_t distances_before = distance_evaluations.load();
+    size_t allocations_before = allocation_count().load();
 
     size_t no_improvement_count = 0;
     double best_fitness_prev = -std::numeric_limits<double>::infinity();
+    bool elite_scored_full = false; // population[0] holds an elite scored on the full data
+    
+    // Children are produced in pairs; slot 0 is kept for the elite
+    const size_t num_pairs = population_size / 2;
     
     // Main evolution loop
-    for (current_generation = 0; current_generation < max_generations; ++current_generation) {
-        std::vector<Individual<T>> new_population;
-        
+    for (current_generation = 0; current_generation < generations; ++current_generation) {
+        const auto generation_start = std::chrono::steady_clock::now();
+
         // Elitism - save the best individual
         auto best_it = std::max_element(population.begin(), population.end(),
             [](const Individual<T>& a, const Individual<T>& b) {
                 return a.fitness < b.fitness;
             });
-        new_population.push_back(*best_it);
+        if (minibatch) {
+            PhaseTimer timer(main_times, Phase::Fitness);
+            // Batch fitness is an estimate: the candidate is confirmed on the
+            // full data and kept only if it beats the previous elite in slot 0
+            if (!elite_scored_full || best_it != population.begin()) {
+                score_full(*best_it);
+            }
+            if (elite_scored_full && population[0].fitness >= best_it->fitness) {
+                best_it = population.begin();
+            }
+            elite_scored_full = true;
+        }
+        next_population[0] = *best_it;
+        if (memetic_target == MemeticTarget::Elite || memetic_target == MemeticTarget::Both) {
+            PhaseTimer timer(main_times, Phase::Refinement);
+            // In mini-batch mode the elite stays scored on the full data
+            refine(next_population[0], minibatch ? *data : *fitness_data);
+            if (next_population[0].fitness < best_it->fitness) {
+                next_population[0] = *best_it;
+            }
+        }
+
+        if (minibatch && resample_interval != 0 && current_generation > 0 &&
+            current_generation % resample_interval == 0) {
+            PhaseTimer timer(main_times, Phase::Fitness);
+            draw_batch(&next_population[0]);
+        }
 
         // Generation of a new generation
-        while (new_population.size() < population_size) {
-            // Selection
-            Individual<T> parent1 = tournament_selection(3);
-            Individual<T> parent2 = tournament_selection(3);
-            
-            // Crossover
-            Individual<T> child1, child2;
-            if (std::uniform_real_distribution<double>(0.0, 1.0)(rng) < crossover_rate) {
-                crossover(parent1, parent2, child1, child2);
-            } else {
-                child1 = parent1;
-                child2 = parent2;
-            }
-            
-            // Mutation
-            mutate(child1);
-            mutate(child2);
-            
-            // Fitness assessment
-            child1.fitness = compute_fitness(child1);
-            child2.fitness = compute_fitness(child2);
-            
-            // Adding to a new population
-            if (new_population.size() < population_size) new_population.push_back(child1);
-            if (new_population.size() < population_size) new_population.push_back(child2);
+        if (pool) {
+            // Each worker breeds a fixed range of pairs with its own stream
+            auto breed_chunk = [&](size_t worker) {
+                breed(worker * num_pairs / num_threads, (worker + 1) * num_pairs / num_threads,
+                      worker_rngs[worker], observer ? &worker_times[worker] : nullptr);
+            };
+            pool->run(breed_chunk);
+        } else {
+            breed(0, num_pairs, rng, main_times);
+        }
+        if (incremental_assignment) {
+            PhaseTimer timer(main_times, Phase::Fitness);
+            settle_borrowed_bounds();
         }
         
-        population = new_population;
+        // The finished offspring become the population; the old buffer is reused next time
+        population.swap(next_population);
+        // Not estimated for the new population (yet); telemetry reports 0 then
+        current_diversity = 0.0;
+        diversity_estimated = false;
         
         // Checking the improvement
-        double best_current = best_it->fitness;
+        double best_current = population[0].fitness;
         if (best_current <= best_fitness_prev + 1e-6) {
             no_improvement_count++;
         } else {
@@ -99,30 +377,349 @@ void GeneticClustering<T>::fit(const std::vector<Point<T>>& input_data) {
         }
         best_fitness_prev = best_current;
         
-        // Logging
-        if (current_generation % 10 == 0) {
-            double avg_fitness = std::accumulate(population.begin(), population.end(), 0.0,
+        // Diversity is estimated at most once per generation and shared
+        // by the logging and the convergence check
+        const bool log_generation = verbose && current_generation % 10 == 0;
+        if (log_generation || diversity_threshold != 0) {
+            PhaseTimer timer(main_times, Phase::Diversity);
+            cached_diversity();
+        }
+        
+        double avg_fitness = 0.0;
+        if (log_generation || observer) {
+            avg_fitness = std::accumulate(population.begin(), population.end(), 0.0,
                 [](double sum, const Individual<T>& ind) { return sum + ind.fitness; }) / static_cast<double>(population_size);
-            
+        }
+
+        // Telemetry
+        if (observer) {
+            GenerationStats stats;
+            stats.generation = current_generation;
+            stats.best_fitness = best_current;
+            stats.average_fitness = avg_fitness;
+            stats.diversity = current_diversity;
+            for (auto& times : worker_times) {
+                stats.phases += times;
+                times = PhaseTimes();
+            }
+            const size_t evaluations_now = evaluations_computed.load();
+            const size_t distances_now = distance_evaluations.load();
+            const size_t allocations_now = allocation_count().load();
+            stats.evaluations = evaluations_now - evaluations_before;
+            stats.distance_evaluations = distances_now - distances_before;
+            stats.allocations = allocations_now - allocations_before;
+            evaluations_before = evaluations_now;
+            distances_before = distances_now;
+            stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - generation_start).count();
+            stats.generations_per_second = stats.seconds > 0.0 ? 1.0 / stats.seconds : 0.0;
+            totals.phases += stats.phases;
+            observer->on_generation(stats);
+            // Allocations of the observer itself are not attributed to the next generation
+            allocations_before = allocation_count().load();
+        }
+        
+        // Logging
+        if (log_generation) {
             std::cout << "Generation " << current_generation 
                       << ", Best fitness: " << best_current
                       << ", Avg fitness: " << avg_fitness
-                      << ", Diversity: " << calculate_diversity() << std::endl;
+                      << ", Diversity: " << current_diversity << std::endl;
         }
         
         // Checking the stopping criteria
-        if (should_stop(current_generation, no_improvement_count, best_current)) {
-            std::cout << "Early stopping at generation " << current_generation << std::endl;
+        if (should_stop(current_generation, generations, no_improvement_count, best_current)) {
+            if (verbose) {
+                std::cout << "Early stopping at generation " << current_generation << std::endl;
+            }
             break;
         }
     }
+
+    // Final results are reported on the full data
+    if (minibatch) {
+        PhaseTimer timer(main_times, Phase::Fitness);
+        if (pool) {
+            auto score_chunk = [&](size_t worker) {
+                const size_t first = worker * population_size / num_threads;
+                const size_t last = (worker + 1) * population_size / num_threads;
+                for (size_t i = first; i < last; ++i) {
+                    score_full(population[i]);
+                }
+            };
+            pool->run(score_chunk);
+        } else {
+            for (auto& individual : population) {
+                score_full(individual);
+            }
+        }
+    }
+    fitness_data = data.get();
+    fitness_scale = 1.0;
+
+    if (observer) {
+        const auto best_it = std::max_element(population.begin(), population.end(),
+            [](const Individual<T>& a, const Individual<T>& b) {
+                return a.fitness < b.fitness;
+            });
+        for (auto& times : worker_times) {
+            totals.phases += times; // Final scoring
+        }
+        // The loop variable stops at max_generations or at the generation that stopped early
+        totals.generation = std::min(current_generation + 1, generations);
+        totals.best_fitness = best_it->fitness;
+        totals.average_fitness = std::accumulate(population.begin(), population.end(), 0.0,
+            [](double sum, const Individual<T>& ind) { return sum + ind.fitness; }) / static_cast<double>(population_size);
+        totals.diversity = current_diversity;
+        totals.evaluations = evaluations_computed.load();
+        totals.distance_evaluations = distance_evaluations.load();
+        totals.allocations = allocation_count().load() - allocations_at_start;
+        totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - fit_start).count();
+        totals.generations_per_second = totals.seconds > 0.0 ? static_cast<double>(totals.generation) / totals.seconds : 0.0;
+        observer->on_fit_end(totals);
+    }
 }
 
 template <typename T>
-bool GeneticClustering<T>::should_stop(size_t generation, size_t no_improvement_count, 
+void GeneticClustering<T>::rescore_population(size_t old_rows, WarmStart mode) {
+    const size_t n = data->rows();
+    const size_t dim = data->dimension();
+
+    if (mode == WarmStart::BestCentroids) {
+        auto best_it = std::max_element(population.begin(), population.end(),
+            [](const Individual<T>& a, const Individual<T>& b) {
+                return a.fitness < b.fitness;
+            });
+        std::iter_swap(population.begin(), best_it);
+    }
+
+    auto rescore = [&](size_t i, std::mt19937& generator) {
+        Individual<T>& individual = population[i];
+        // Bounds cover the old points only; children fall back to a full pass
+        individual.distances.clear();
+        individual.lower_bounds.clear();
+        if (mode == WarmStart::BestCentroids && i > 0) {
+            individual.initialize(k, *data, generator);
+            individual.fitness = compute_fitness(individual);
+        } else if (!individual.dirty && !individual.stale_labels && old_rows > 0 &&
+                   individual.labels.size() == old_rows) {
+            // Labels of the old points are current: only the new points are
+            // assigned, and the distance sum of the old ones (exact, as the
+            // last generation was scored on the full data) loses the decay
+            individual.labels.resize(n);
+            individual.labelled_points = data.get();
+            const AssignmentResult assignment = DistanceKernels<T>::assign_nearest(
+                data->row(old_rows), n - old_rows, individual.centroids.data(),
+                individual.centroids.rows(), dim, individual.labels.data() + old_rows);
+            const double old_distance = 1.0 / individual.fitness - 1.0;
+            const double old_weight = n > old_rows && decay < 1.0 ? decay : 1.0;
+            individual.fitness = 1.0 / (1.0 + old_distance * old_weight + assignment.sum_distance);
+            evaluations_computed++;
+            distance_evaluations += assignment.distance_evaluations;
+        } else {
+            score_full(individual);
+        }
+    };
+
+    if (pool) {
+        auto rescore_chunk = [&](size_t worker) {
+            const size_t first = worker * population_size / num_threads;
+            const size_t last = (worker + 1) * population_size / num_threads;
+            for (size_t i = first; i < last; ++i) {
+                rescore(i, worker_rngs[worker]);
+            }
+        };
+        pool->run(rescore_chunk);
+    } else {
+        for (size_t i = 0; i < population_size; ++i) {
+            rescore(i, rng);
+        }
+    }
+}
+
+template <typename T>
+bool GeneticClustering<T>::weighted() const {
+    return segment_weights.size() > 1;
+}
+
+template <typename T>
+double GeneticClustering<T>::assign_weighted(Individual<T>& individual) {
+    const size_t n = data->rows();
+    const size_t dim = data->dimension();
+    individual.labels.resize(n);
+    individual.labelled_points = data.get();
+    // Bounds do not apply to weighted sums
+    individual.distances.clear();
+    individual.lower_bounds.clear();
+
+    double weighted_distance = 0.0;
+    for (size_t s = 0; s < segment_starts.size(); ++s) {
+        const size_t first = segment_starts[s];
+        const size_t last = s + 1 < segment_starts.size() ? segment_starts[s + 1] : n;
+        const AssignmentResult assignment = DistanceKernels<T>::assign_nearest(
+            data->row(first), last - first, individual.centroids.data(),
+            individual.centroids.rows(), dim, individual.labels.data() + first);
+        weighted_distance += segment_weights[s] * assignment.sum_distance;
+        distance_evaluations += assignment.distance_evaluations;
+    }
+    individual.dirty = false;
+    individual.stale_labels = false;
+    evaluations_computed++;
+    return 1.0 / (1.0 + weighted_distance);
+}
+
+template <typename T>
+void GeneticClustering<T>::save_checkpoint(const std::string& filename) const {
+    if (population.empty()) {
+        throw std::runtime_error("There is no population to save");
+    }
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open the file: " + filename);
+    }
+
+    auto write_u64 = [&](uint64_t value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto write_double = [&](double value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    // Generator states in their portable text form
+    auto write_engine = [&](const std::mt19937& engine) {
+        std::ostringstream state;
+        state << engine;
+        const std::string text = state.str();
+        write_u64(text.size());
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    };
+
+    const size_t dim = population[0].centroids.dimension();
+    file.write(checkpoint_magic, sizeof(checkpoint_magic));
+    write_u64(checkpoint_version);
+    write_u64(sizeof(T));
+    write_u64(std::is_floating_point_v<T> ? 1 : 0);
+    write_u64(k);
+    write_u64(dim);
+    write_u64(population.size());
+    write_u64(seed);
+    write_u64(data ? data->rows() : resume_rows);
+    write_u64(segment_starts.size());
+    for (size_t s = 0; s < segment_starts.size(); ++s) {
+        write_u64(segment_starts[s]);
+        write_double(segment_weights[s]);
+    }
+    write_engine(rng);
+    write_u64(worker_rngs.size());
+    for (const auto& engine : worker_rngs) {
+        write_engine(engine);
+    }
+    for (const auto& individual : population) {
+        write_double(individual.fitness);
+        file.write(reinterpret_cast<const char*>(individual.centroids.data()),
+                   static_cast<std::streamsize>(k * dim * sizeof(T)));
+    }
+
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Could not write the file: " + filename);
+    }
+}
+
+template <typename T>
+void GeneticClustering<T>::load_checkpoint(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open the file: " + filename);
+    }
+
+    auto fail = [&]() {
+        throw std::runtime_error("Invalid checkpoint file: " + filename);
+    };
+    auto read_u64 = [&]() {
+        uint64_t value = 0;
+        if (!file.read(reinterpret_cast<char*>(&value), sizeof(value))) fail();
+        return value;
+    };
+    auto read_double = [&]() {
+        double value = 0.0;
+        if (!file.read(reinterpret_cast<char*>(&value), sizeof(value))) fail();
+        return value;
+    };
+    auto read_engine = [&](std::mt19937& engine) {
+        const uint64_t length = read_u64();
+        if (length > (1u << 16)) fail();
+        std::string text(length, '\0');
+        if (!file.read(&text[0], static_cast<std::streamsize>(length))) fail();
+        std::istringstream state(text);
+        state >> engine;
+        if (state.fail()) fail();
+    };
+
+    char magic[sizeof(checkpoint_magic)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 ||
+        read_u64() != checkpoint_version) {
+        fail();
+    }
+    if (read_u64() != sizeof(T) || read_u64() != (std::is_floating_point_v<T> ? 1u : 0u)) {
+        throw std::runtime_error("Checkpoint was saved for a different coordinate type: " + filename);
+    }
+    if (read_u64() != k) {
+        throw std::runtime_error("Checkpoint was saved for a different number of clusters: " + filename);
+    }
+    const size_t dim = read_u64();
+    const size_t individuals = read_u64();
+    const unsigned int saved_seed = static_cast<unsigned int>(read_u64());
+    const size_t rows = read_u64();
+    const size_t segments = read_u64();
+    if (dim == 0 || individuals == 0 || segments > rows + 1) fail();
+
+    std::vector<size_t> starts(segments);
+    std::vector<double> weights(segments);
+    for (size_t s = 0; s < segments; ++s) {
+        starts[s] = read_u64();
+        weights[s] = read_double();
+        // Segments start at the first row and partition the rows in order
+        if (starts[s] >= rows || (s == 0 ? starts[s] != 0 : starts[s] <= starts[s - 1])) fail();
+    }
+    std::mt19937 saved_rng;
+    read_engine(saved_rng);
+    const size_t workers = read_u64();
+    if (workers > (1u << 16)) fail();
+    std::vector<std::mt19937> saved_workers(workers);
+    for (auto& engine : saved_workers) {
+        read_engine(engine);
+    }
+    std::vector<Individual<T>> saved_population(individuals);
+    for (auto& individual : saved_population) {
+        individual.fitness = read_double();
+        individual.centroids.resize(k, dim);
+        if (!file.read(reinterpret_cast<char*>(individual.centroids.data()),
+                       static_cast<std::streamsize>(k * dim * sizeof(T)))) {
+            fail();
+        }
+        // Labels are recomputed against the data on resume
+        individual.dirty = false;
+        individual.stale_labels = true;
+    }
+
+    // The file was read completely; only now the state is replaced
+    population = std::move(saved_population);
+    population_size = individuals;
+    diversity_estimated = false;
+    seed = saved_seed;
+    rng = saved_rng;
+    worker_rngs = std::move(saved_workers);
+    segment_starts = std::move(starts);
+    segment_weights = std::move(weights);
+    resume_rows = rows;
+    data.reset();
+    owned_data.reset();
+}
+
+template <typename T>
+bool GeneticClustering<T>::should_stop(size_t generation, size_t generations, size_t no_improvement_count,
                                      double current_best_fitness) const {
     // 1. Maximum generations reached
-    if (generation >= max_generations && max_generations != 0) return true;
+    if (generation >= generations && generations != 0) return true;
     
     // 2. No improvements for max_no_improvement generations
     if (no_improvement_count >= max_no_improvement && max_no_improvement != 0) return true;
@@ -138,47 +735,59 @@ bool GeneticClustering<T>::should_stop(size_t generation, size_t no_improvement_
 
 template <typename T>
 bool GeneticClustering<T>::is_converged() const {
-    return calculate_diversity() < diversity_threshold;
+    return current_diversity < diversity_threshold;
 }
 
 template <typename T>
 double GeneticClustering<T>::calculate_diversity() const {
-    EuclideanDistance<T> metric;
-    double total_distance = 0.0;
-    size_t count = 0;
-    
-    for (size_t i = 0; i < population.size(); ++i) {
-        for (size_t j = i + 1; j < population.size(); ++j) {
-            for (size_t c = 0; c < k; ++c) {
-                total_distance += metric.compute(
-                    population[i].centroids[c],
-                    population[j].centroids[c]
-                );
-                count++;
-            }
-        }
+    return diversity_estimator->estimate(population);
+}
+
+template <typename T>
+double GeneticClustering<T>::cached_diversity() const {
+    if (!diversity_estimated && !population.empty()) {
+        current_diversity = calculate_diversity();
+        diversity_estimated = true;
     }
-    
-    return count > 0 ? total_distance / (double)count : 0.0;
+    return current_diversity;
 }
 
 template <typename T>
 Individual<T> GeneticClustering<T>::get_best_solution() const {
-    return *std::max_element(population.begin(), population.end(),
+    if (!data) {
+        throw std::runtime_error("There is no data to evaluate on; call partial_fit after load_checkpoint");
+    }
+    Individual<T> best = *std::max_element(population.begin(), population.end(),
         [](const Individual<T>& a, const Individual<T>& b) {
             return a.fitness < b.fitness;
         });
+    // Fitness may have been carried over without recomputing the labels
+    if (best.stale_labels) {
+        best.update_labels(*data);
+    }
+    return best;
 }
 
 template <typename T>
 double GeneticClustering<T>::computeWCSS(const Individual<T>& individual) const {
+    if (!data) {
+        throw std::runtime_error("There is no data to evaluate on; call partial_fit after load_checkpoint");
+    }
+    if (individual.stale_labels) {
+        // Labels do not belong to the centroids; assign a copy
+        std::vector<size_t> labels(data->rows());
+        return DistanceKernels<T>::assign_nearest(data->data(), data->rows(),
+                                                  individual.centroids.data(), individual.centroids.rows(),
+                                                  data->dimension(), labels.data()).sum_squared;
+    }
+
     double total_error = 0.0;
-    EuclideanDistance<T> metric;
+    const size_t dim = data->dimension();
     
-    for (size_t i = 0; i < data.size(); ++i) {
+    for (size_t i = 0; i < data->rows(); ++i) {
         size_t cluster_idx = individual.labels[i];
-        const Point<T>& centroid = individual.centroids[cluster_idx];
-        total_error += metric.compute(data[i], centroid) * metric.compute(data[i], centroid);
+        const T* centroid = individual.centroids.row(cluster_idx);
+        total_error += static_cast<double>(DistanceKernels<T>::squared_distance(data->row(i), centroid, dim));
     }
     
     return total_error;
@@ -191,57 +800,346 @@ double GeneticClustering<T>::getBestWCSS() const {
 }
 
 template <typename T>
-double GeneticClustering<T>::compute_fitness(Individual<T>& individual) {
-    individual.update_labels(data);
-    EuclideanDistance<T> metric;
-    double sum_distances = 0.0;
-    
-    for (size_t i = 0; i < data.size(); ++i) {
-        size_t cluster = static_cast<size_t>(individual.labels[i]);
-        sum_distances += metric.compute(data[i], individual.centroids[cluster]);
+double GeneticClustering<T>::compute_fitness(Individual<T>& individual, const Individual<T>* parent) {
+    // Decayed batches weigh less; bounds do not apply to weighted sums
+    if (weighted()) return assign_weighted(individual);
+
+    AssignmentResult assignment;
+    if (!incremental_assignment) {
+        // Labels and distances come from one batched nearest-centroid pass
+        assignment = individual.update_labels(*fitness_data);
+    } else if (parent) {
+        assignment = individual.update_labels_from(*fitness_data, *parent);
+    } else {
+        assignment = individual.update_labels_with_bounds(*fitness_data);
     }
-    
-    return 1.0 / (1.0 + sum_distances);
+    individual.dirty = false;
+    // Labels of a mini-batch do not cover the data
+    individual.stale_labels = fitness_data != data.get();
+    evaluations_computed++;
+    distance_evaluations += assignment.distance_evaluations;
+    return 1.0 / (1.0 + assignment.sum_distance * fitness_scale);
+}
+
+template <typename T>
+void GeneticClustering<T>::score_full(Individual<T>& individual) {
+    if (weighted()) {
+        individual.fitness = assign_weighted(individual);
+        return;
+    }
+    const AssignmentResult assignment = individual.update_labels(*data);
+    individual.fitness = 1.0 / (1.0 + assignment.sum_distance);
+    individual.dirty = false;
+    evaluations_computed++;
+    distance_evaluations += assignment.distance_evaluations;
+}
+
+template <typename T>
+void GeneticClustering<T>::refine(Individual<T>& individual, const PointMatrix<T>& points) {
+    if (lloyd_steps == 0) return;
+
+    // Lloyd steps need labels of the current centroids on the same points
+    const double scale = static_cast<double>(data->rows()) / static_cast<double>(points.rows());
+    auto relabel = [&]() {
+        // Weighted data is never sampled, so points is the full data here
+        if (weighted()) {
+            individual.fitness = assign_weighted(individual);
+            return;
+        }
+        const AssignmentResult assignment = individual.update_labels(points);
+        individual.fitness = 1.0 / (1.0 + assignment.sum_distance * scale);
+        evaluations_computed++;
+        distance_evaluations += assignment.distance_evaluations;
+    };
+    // stale_labels is also set for labels of a mini-batch, which are the
+    // ones needed when refining on that batch
+    if (individual.labelled_points != &points) {
+        relabel();
+    }
+
+    for (size_t step = 0; step < lloyd_steps; ++step) {
+        const double shift = individual.update_centroids(points);
+        if (shift == 0.0) break; // Converged: labels and fitness are current
+        relabel();
+        if (shift <= lloyd_tolerance) break;
+    }
+    individual.dirty = false;
+    individual.stale_labels = &points != data.get();
 }
 
 template <typename T>
-Individual<T> GeneticClustering<T>::tournament_selection(size_t tournament_size) {
+void GeneticClustering<T>::draw_batch(const Individual<T>* elite) {
+    const size_t n = data->rows();
+    batch_rows.clear();
+
+    if (sampling == SamplingStrategy::Stratified && elite && !elite->stale_labels &&
+        elite->labels.size() == n) {
+        // Proportional allocation: every cluster of the elite gets its share
+        // of the batch (largest remainder rounding), so every point keeps the
+        // same weight n / batch_size
+        const size_t clusters = elite->centroids.rows();
+        stratum_counts.assign(2 * clusters, 0);
+        size_t* rows_in = stratum_counts.data();
+        size_t* quota = stratum_counts.data() + clusters;
+        for (size_t i = 0; i < n; ++i) {
+            rows_in[elite->labels[i]]++;
+        }
+        size_t assigned = 0;
+        for (size_t c = 0; c < clusters; ++c) {
+            quota[c] = rows_in[c] * batch_size / n;
+            assigned += quota[c];
+        }
+        while (assigned < batch_size) {
+            size_t largest = clusters;
+            size_t largest_remainder = 0;
+            for (size_t c = 0; c < clusters; ++c) {
+                const size_t remainder = rows_in[c] * batch_size % n;
+                const bool rounded_up = quota[c] != rows_in[c] * batch_size / n;
+                if (!rounded_up && quota[c] < rows_in[c] &&
+                    (largest == clusters || remainder > largest_remainder)) {
+                    largest = c;
+                    largest_remainder = remainder;
+                }
+            }
+            quota[largest]++;
+            assigned++;
+        }
+
+        // Selection sampling within every cluster in one pass: a row is taken
+        // with probability (still needed) / (still available)
+        for (size_t i = 0; i < n; ++i) {
+            const size_t c = elite->labels[i];
+            if (quota[c] == 0) {
+                rows_in[c]--;
+                continue;
+            }
+            if (std::uniform_int_distribution<size_t>(0, rows_in[c] - 1)(rng) < quota[c]) {
+                batch_rows.push_back(i);
+                quota[c]--;
+            }
+            rows_in[c]--;
+        }
+    } else {
+        // Reservoir sampling with geometric skips (Li's algorithm L), which
+        // needs O(batch_size * log(n / batch_size)) random numbers
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        auto open_unit = [&]() {
+            double u = unit(rng);
+            while (u <= 0.0) u = unit(rng);
+            return u;
+        };
+        for (size_t i = 0; i < batch_size; ++i) {
+            batch_rows.push_back(i);
+        }
+        double w = std::exp(std::log(open_unit()) / static_cast<double>(batch_size));
+        size_t i = batch_size - 1;
+        while (true) {
+            const double skip = std::floor(std::log(open_unit()) / std::log1p(-w));
+            if (skip >= static_cast<double>(n - i)) break;
+            i += static_cast<size_t>(skip) + 1;
+            if (i >= n) break;
+            batch_rows[std::uniform_int_distribution<size_t>(0, batch_size - 1)(rng)] = i;
+            w *= std::exp(std::log(open_unit()) / static_cast<double>(batch_size));
+        }
+        // Rows are copied in data order for locality
+        std::sort(batch_rows.begin(), batch_rows.end());
+    }
+
+    batch.resize(batch_rows.size(), data->dimension());
+    for (size_t b = 0; b < batch_rows.size(); ++b) {
+        batch.set_row(b, data->row(batch_rows[b]));
+    }
+    fitness_data = &batch;
+    fitness_scale = static_cast<double>(n) / static_cast<double>(batch_rows.size());
+
+    // Fitness values, labels and bounds of the previous batch no longer
+    // apply; both buffers are cleared, as the batch is refilled in place
+    if (fitness_cache) fitness_cache->clear();
+    for (auto* buffer : {&population, &next_population}) {
+        for (auto& individual : *buffer) {
+            if (individual.labelled_points == &batch) individual.labelled_points = nullptr;
+            individual.distances.clear();
+            individual.lower_bounds.clear();
+        }
+    }
+}
+
+template <typename T>
+void GeneticClustering<T>::evaluate(Individual<T>& child, const Individual<T>& parent) {
+    if (!child.dirty) {
+        // Exact copy of the parent: the fitness carries over. Incremental
+        // assignment needs labels and bounds of every parent, so they are
+        // handed over if they were computed on the points fitness is scored
+        // on; otherwise they are recomputed only if someone asks for them
+        evaluations_skipped++;
+        if (incremental_assignment && parent.labelled_points == fitness_data) {
+            if (memetic_target == MemeticTarget::Offspring || memetic_target == MemeticTarget::Both) {
+                // Refinement right after breeding needs the labels now
+                child.labels = parent.labels;
+                child.distances = parent.distances;
+                child.lower_bounds = parent.lower_bounds;
+            } else {
+                // Other children may still read the parent's bounds; the
+                // buffers change hands once breeding is done
+                bounds_donor[static_cast<size_t>(&child - next_population.data())] =
+                    static_cast<size_t>(&parent - population.data());
+            }
+            child.labelled_points = parent.labelled_points;
+            child.stale_labels = parent.stale_labels;
+        } else {
+            // The slot still holds labels and bounds of its previous occupant
+            child.labelled_points = nullptr;
+            child.distances.clear();
+            child.lower_bounds.clear();
+            child.stale_labels = true;
+        }
+        return;
+    }
+
+    if (fitness_cache && !incremental_assignment) {
+        const uint64_t key = child.centroid_hash();
+        double cached;
+        if (fitness_cache->lookup(key, cached)) {
+            evaluations_cached++;
+            child.fitness = cached;
+            child.dirty = false;
+            child.stale_labels = true;
+            child.labelled_points = nullptr;
+            return;
+        }
+        child.fitness = compute_fitness(child, &parent);
+        fitness_cache->store(key, child.fitness);
+        return;
+    }
+
+    child.fitness = compute_fitness(child, &parent);
+}
+
+template <typename T>
+void GeneticClustering<T>::settle_borrowed_bounds() {
+    // The parents are discarded after breeding: the first unchanged child of
+    // a parent swaps buffers with it, later ones copy from that child
+    for (size_t slot = 1; slot < population_size; ++slot) {
+        const size_t parent = bounds_donor[slot];
+        if (parent == no_donor) continue;
+        bounds_donor[slot] = no_donor;
+        Individual<T>& child = next_population[slot];
+        if (donor_holder[parent] == no_donor) {
+            child.labels.swap(population[parent].labels);
+            child.distances.swap(population[parent].distances);
+            child.lower_bounds.swap(population[parent].lower_bounds);
+            population[parent].labelled_points = nullptr;
+            donor_holder[parent] = slot;
+        } else {
+            const Individual<T>& holder = next_population[donor_holder[parent]];
+            child.labels = holder.labels;
+            child.distances = holder.distances;
+            child.lower_bounds = holder.lower_bounds;
+        }
+    }
+    std::fill(donor_holder.begin(), donor_holder.end(), no_donor);
+}
+
+template <typename T>
+size_t GeneticClustering<T>::tournament_selection(size_t tournament_size,
+                                                 std::mt19937& generator) const {
     std::uniform_int_distribution<size_t> dist(0, population_size - 1);
-    Individual<T> best;
-    best.fitness = -std::numeric_limits<double>::infinity();
+    size_t best = dist(generator);
     
-    for (size_t i = 0; i < tournament_size; ++i) {
-        size_t idx = dist(rng);
-        if (population[idx].fitness > best.fitness) {
-            best = population[idx];
+    for (size_t i = 1; i < tournament_size; ++i) {
+        size_t idx = dist(generator);
+        if (population[idx].fitness > population[best].fitness) {
+            best = idx;
         }
     }
     return best;
 }
 
 template <typename T>
-void GeneticClustering<T>::crossover(Individual<T>& parent1, Individual<T>& parent2, 
-                                   Individual<T>& child1, Individual<T>& child2) {
+void GeneticClustering<T>::crossover(Individual<T>& child1, Individual<T>& child2,
+                                   std::mt19937& generator) {
     std::uniform_int_distribution<size_t> dist(1, k - 1);
-    size_t crossover_point = dist(rng);
-    
-    child1.centroids.clear();
-    child2.centroids.clear();
+    size_t crossover_point = dist(generator);
     
-    for (size_t i = 0; i < crossover_point; ++i) {
-        child1.centroids.push_back(parent1.centroids[i]);
-        child2.centroids.push_back(parent2.centroids[i]);
+    // Children hold copies of their parents; exchanging the centroids after
+    // the crossover point gives parent1[0, p) + parent2[p, k) and vice versa
+    const size_t dim = data->dimension();
+    T* tail1 = child1.centroids.row(crossover_point);
+    T* tail2 = child2.centroids.row(crossover_point);
+    const size_t tail_size = (k - crossover_point) * dim;
+    if (!std::equal(tail1, tail1 + tail_size, tail2)) {
+        std::swap_ranges(tail1, tail1 + tail_size, tail2);
+        child1.dirty = true;
+        child2.dirty = true;
     }
-    
-    for (size_t i = crossover_point; i < k; ++i) {
-        child1.centroids.push_back(parent2.centroids[i]);
-        child2.centroids.push_back(parent1.centroids[i]);
+}
+
+template <typename T>
+void GeneticClustering<T>::mutate(Individual<T>& individual, std::mt19937& generator) {
+    for (size_t c = 0; c < individual.centroids.rows(); ++c) {
+        if (mutation_op->mutate(individual.centroids.row(c), data->dimension(), generator)) {
+            individual.dirty = true;
+        }
     }
 }
 
 template <typename T>
-void GeneticClustering<T>::mutate(Individual<T>& individual) {
-    for (auto& centroid : individual.centroids) {
-        mutation_op->mutate(centroid, rng);
+void GeneticClustering<T>::breed(size_t first_pair, size_t last_pair, std::mt19937& generator,
+                                 PhaseTimes* times) {
+    for (size_t pair = first_pair; pair < last_pair; ++pair) {
+        // The second child of the last pair has no slot when the population size is even
+        const size_t slot = 1 + 2 * pair;
+        Individual<T>& child1 = next_population[slot];
+        Individual<T>& child2 = slot + 1 < population_size ? next_population[slot + 1] : spare_child;
+        
+        // Selection
+        size_t parent1, parent2;
+        {
+            PhaseTimer timer(times, Phase::Selection);
+            parent1 = tournament_selection(3, generator);
+            parent2 = tournament_selection(3, generator);
+            
+            // Children start as clean copies of the parents' centroids and fitness
+            // (labels are recomputed or copied once it is known whether they changed)
+            child1.centroids = population[parent1].centroids;
+            child2.centroids = population[parent2].centroids;
+            child1.fitness = population[parent1].fitness;
+            child2.fitness = population[parent2].fitness;
+            child1.dirty = false;
+            child2.dirty = false;
+        }
+        
+        // Crossover
+        {
+            PhaseTimer timer(times, Phase::Crossover);
+            if (std::uniform_real_distribution<double>(0.0, 1.0)(generator) < crossover_rate) {
+                crossover(child1, child2, generator);
+            }
+        }
+        
+        // Mutation
+        {
+            PhaseTimer timer(times, Phase::Mutation);
+            mutate(child1, generator);
+            mutate(child2, generator);
+        }
+        
+        // Fitness assessment
+        // Each child keeps the head of one parent, whose bounds it starts from
+        {
+            PhaseTimer timer(times, Phase::Fitness);
+            evaluate(child1, population[parent1]);
+            if (&child2 != &spare_child) {
+                evaluate(child2, population[parent2]);
+            }
+        }
+
+        if (memetic_target == MemeticTarget::Offspring || memetic_target == MemeticTarget::Both) {
+            PhaseTimer timer(times, Phase::Refinement);
+            refine(child1, *fitness_data);
+            if (&child2 != &spare_child) {
+                refine(child2, *fitness_data);
+            }
+        }
     }
-}
\ No newline at end of file
+}
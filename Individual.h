@@ -1,8 +1,11 @@
 #pragma once
 #include <vector>
 #include <random>
+#include <cstdint>
 #include "DistanceMetric.h"
+#include "DistanceKernels.h"
 #include "Point.h"
+#include "PointMatrix.h"
 
 // A templated class representing an individual solution in a clustering algorithm
 // T is the numeric type used for point coordinates (e.g., double, float)
@@ -10,38 +13,98 @@ template <typename T>
 class Individual {
 public:
     // Cluster centroids (representative points for each cluster)
-    std::vector<Point<T>> centroids;
+    // One row per cluster, stored contiguously
+    PointMatrix<T> centroids;
 
     // Cluster labels for each data point (indicates which cluster each point belongs to)
     // labels.size() should equal the number of data points
     std::vector<size_t> labels;
 
+    // Bounds for incremental label assignment (empty unless it is used)
+    // distances[i] - exact distance from point i to its assigned centroid
+    // lower_bounds[i] - lower bound on the distance from point i to any other centroid
+    std::vector<double> distances;
+    std::vector<double> lower_bounds;
+
     // Fitness value evaluating the quality of this clustering solution
     // Higher fitness typically indicates better clustering
     double fitness;
 
+    // True when centroids changed since fitness was last computed
+    bool dirty;
+
+    // True when fitness is current but labels were not recomputed for the
+    // current centroids (fitness was carried over or taken from a cache)
+    bool stale_labels;
+
+    // Points that labels (and bounds, when present) were assigned on with
+    // the current centroids; null when they belong to no point set
+    const PointMatrix<T>* labelled_points;
+
     // Default constructor
     // Initializes with empty centroids, labels, and zero fitness
     Individual();
 
+    // 64-bit FNV-1a hash of the centroid coordinates
+    // Equal centroids always give equal hashes
+    uint64_t centroid_hash() const;
+
     // Initializes the individual with random centroids
     // Parameters:
     //   k - number of clusters to create
     //   data - reference to the dataset being clustered
     //   rng - random number generator for probabilistic operations
-    void initialize(size_t k, const std::vector<Point<T>>& data, std::mt19937& rng);
+    void initialize(size_t k, const PointMatrix<T>& data, std::mt19937& rng);
 
     // Updates cluster labels for all data points based on current centroids
     // (Assigns each point to its nearest centroid)
     // Parameters:
     //   data - reference to the dataset being clustered
-    void update_labels(const std::vector<Point<T>>& data);
+    // Returns:
+    //   Sum of distances and squared distances to the assigned centroids
+    AssignmentResult update_labels(const PointMatrix<T>& data);
 
-    // Recalculates centroids based on current cluster assignments
-    // (Computes mean of all points in each cluster)
+    // Same as update_labels, but also fills distances and lower_bounds
+    // so that children can be assigned incrementally
+    AssignmentResult update_labels_with_bounds(const PointMatrix<T>& data);
+
+    // Assigns labels starting from the labels and bounds of a parent
+    // (Only the centroids that differ from the parent's centroid with the same
+    // index are measured; the parent's second nearest distance bounds the
+    // others. Points whose bound no longer proves the assignment are
+    // compared with all centroids, in blocks through the vector kernel)
+    // Falls back to update_labels_with_bounds if the parent has no bounds
+    // for data (parent.labelled_points must be &data) or every centroid moved.
+    // Labels match update_labels up to ties between equally distant centroids.
     // Parameters:
     //   data - reference to the dataset being clustered
-    void update_centroids(const std::vector<Point<T>>& data);
+    //   parent - individual with the same k whose bounds are valid for its centroids
+    AssignmentResult update_labels_from(const PointMatrix<T>& data, const Individual<T>& parent);
+
+    // Recalculates centroids based on current cluster assignments
+    // (Computes mean of all points in each cluster, accumulated in double)
+    // A cluster left without points is reseeded with the point farthest from
+    // its centroid, taken from a cluster that keeps at least one point; its
+    // label is moved accordingly. Does not allocate after the first call.
+    // Parameters:
+    //   data - reference to the dataset being clustered (labels must be current)
+    // Returns:
+    //   The largest distance any centroid moved
+    double update_centroids(const PointMatrix<T>& data);
+
+private:
+    // Points per block of the vector kernel in bounded assignment
+    static constexpr size_t bound_block_rows = 256;
+
+    // Assigns `count` contiguous points with the vector kernel and stores
+    // their labels, distances and second nearest distances (lower bounds)
+    // at the indices rows[b], or first_row + b when rows is null
+    void assign_block(const T* points, size_t count, const size_t* rows, size_t first_row,
+                      AssignmentResult& result);
+
+    // Incremental assignment with the dimension known at compile time (0 = runtime)
+    template <size_t D>
+    AssignmentResult assign_from(const PointMatrix<T>& data, const Individual<T>& parent);
 };
 
 #include "Individual.ipp"
\ No newline at end of file
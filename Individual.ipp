@@ -2,61 +2,328 @@
 #include "DistanceMetric.h"
 #include <limits>
 #include <numeric>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
 
 template <typename T>
-Individual<T>::Individual() : fitness(-std::numeric_limits<double>::infinity()) {}
+Individual<T>::Individual()
+    : fitness(-std::numeric_limits<double>::infinity()), dirty(true), stale_labels(false),
+      labelled_points(nullptr) {}
 
 template <typename T>
-void Individual<T>::initialize(size_t k, const std::vector<Point<T>>& data, std::mt19937& rng) {
-    std::uniform_int_distribution<size_t> dist(0, data.size() - 1);
-    centroids.clear();
+uint64_t Individual<T>::centroid_hash() const {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(centroids.data());
+    const size_t size = centroids.rows() * centroids.dimension() * sizeof(T);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+void Individual<T>::initialize(size_t k, const PointMatrix<T>& data, std::mt19937& rng) {
+    std::uniform_int_distribution<size_t> dist(0, data.rows() - 1);
+    centroids.resize(k, data.dimension());
     
     for (size_t i = 0; i < k; ++i) {
-        centroids.push_back(data[dist(rng)]);
+        centroids.set_row(i, data.row(dist(rng)));
     }
+    dirty = true;
     update_labels(data);
 }
 
 template <typename T>
-void Individual<T>::update_labels(const std::vector<Point<T>>& data) {
-    labels.resize(data.size());
-    EuclideanDistance<T> metric;
-    
-    for (size_t i = 0; i < data.size(); ++i) {
-        double min_dist = std::numeric_limits<double>::max();
-        size_t best_cluster = 0;
-        
-        for (size_t j = 0; j < centroids.size(); ++j) {
-            double dist = metric.compute(data[i], centroids[j]);
-            if (dist < min_dist) {
-                min_dist = dist;
-                best_cluster = j;
+AssignmentResult Individual<T>::update_labels(const PointMatrix<T>& data) {
+    labels.resize(data.rows());
+    stale_labels = false;
+    labelled_points = &data;
+    // Bounds are not maintained here; clearing them keeps the capacity
+    distances.clear();
+    lower_bounds.clear();
+    return DistanceKernels<T>::assign_nearest(data.data(), data.rows(),
+                                              centroids.data(), centroids.rows(),
+                                              data.dimension(), labels.data());
+}
+
+template <typename T>
+double Individual<T>::update_centroids(const PointMatrix<T>& data) {
+    const size_t n = data.rows();
+    const size_t dim = data.dimension();
+    const size_t k = centroids.rows();
+
+    // Per-thread scratch, reused between calls
+    thread_local std::vector<double> sums;
+    thread_local std::vector<size_t> counts;
+    sums.assign(k * dim, 0.0);
+    counts.assign(k, 0);
+
+    for (size_t i = 0; i < n; ++i) {
+        const size_t cluster = labels[i];
+        const T* point = data.row(i);
+        double* sum = sums.data() + cluster * dim;
+        for (size_t j = 0; j < dim; ++j) {
+            sum[j] += static_cast<double>(point[j]);
+        }
+        counts[cluster]++;
+    }
+
+    // Empty clusters take over the worst-served point of a cluster that can
+    // spare one; its distance is measured to the centroid before this update
+    for (size_t empty = 0; empty < k; ++empty) {
+        if (counts[empty] > 0) continue;
+
+        size_t farthest = n;
+        double farthest_distance = -1.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (counts[labels[i]] < 2) continue;
+            const double dist = static_cast<double>(
+                DistanceKernels<T>::squared_distance(data.row(i), centroids.row(labels[i]), dim));
+            if (dist > farthest_distance) {
+                farthest = i;
+                farthest_distance = dist;
             }
         }
-        labels[i] = best_cluster;
+        if (farthest == n) break; // Fewer distinct points than clusters
+
+        const size_t donor = labels[farthest];
+        const T* point = data.row(farthest);
+        for (size_t j = 0; j < dim; ++j) {
+            sums[donor * dim + j] -= static_cast<double>(point[j]);
+            sums[empty * dim + j] = static_cast<double>(point[j]);
+        }
+        counts[donor]--;
+        counts[empty] = 1;
+        labels[farthest] = empty;
+    }
+
+    double max_shift = 0.0;
+    for (size_t c = 0; c < k; ++c) {
+        if (counts[c] == 0) continue; // Keeps its position
+        T* centroid = centroids.row(c);
+        double shift = 0.0;
+        for (size_t j = 0; j < dim; ++j) {
+            const double mean = sums[c * dim + j] / static_cast<double>(counts[c]);
+            T value;
+            if constexpr (std::is_integral_v<T>) {
+                value = static_cast<T>(std::llround(mean));
+            } else {
+                value = static_cast<T>(mean);
+            }
+            const double delta = static_cast<double>(value) - static_cast<double>(centroid[j]);
+            shift += delta * delta;
+            centroid[j] = value;
+        }
+        max_shift = std::max(max_shift, std::sqrt(shift));
+    }
+
+    if (max_shift > 0.0) {
+        dirty = true;
+        labelled_points = nullptr;
+        distances.clear();
+        lower_bounds.clear();
     }
+    return max_shift;
 }
 
 template <typename T>
-void Individual<T>::update_centroids(const std::vector<Point<T>>& data) {
-    std::vector<Point<T>> new_centroids(centroids.size(), std::vector<T>(data[0].coors.size(), 0));
-    std::vector<int> counts(centroids.size(), 0);
-    
-    for (size_t i = 0; i < data.size(); ++i) {
-        size_t cluster = static_cast<size_t>(labels[i]);
-        for (size_t j = 0; j < data[i].coors.size(); ++j) {
-            new_centroids[cluster].coors[j] += data[i].coors[j];
+AssignmentResult Individual<T>::update_labels_with_bounds(const PointMatrix<T>& data) {
+    const size_t n = data.rows();
+    labels.resize(n);
+    distances.resize(n);
+    lower_bounds.resize(n);
+    stale_labels = false;
+    labelled_points = &data;
+
+    AssignmentResult result;
+    for (size_t first = 0; first < n; first += bound_block_rows) {
+        assign_block(data.row(first), std::min(bound_block_rows, n - first), nullptr, first, result);
+    }
+    return result;
+}
+
+template <typename T>
+AssignmentResult Individual<T>::update_labels_from(const PointMatrix<T>& data, const Individual<T>& parent) {
+    if (parent.labelled_points != &data || parent.distances.size() != data.rows() ||
+        parent.centroids.rows() != centroids.rows()) {
+        return update_labels_with_bounds(data);
+    }
+    switch (data.dimension()) {
+        case 2: return assign_from<2>(data, parent);
+        case 3: return assign_from<3>(data, parent);
+        case 8: return assign_from<8>(data, parent);
+        default: return assign_from<0>(data, parent);
+    }
+}
+
+template <typename T>
+void Individual<T>::assign_block(const T* points, size_t count, const size_t* rows, size_t first_row,
+                                 AssignmentResult& result) {
+    using Acc = typename DistanceKernels<T>::Acc;
+    // Per-thread scratch, reused between calls
+    thread_local std::vector<size_t> block_labels;
+    thread_local std::vector<Acc> nearest;
+    thread_local std::vector<Acc> second;
+    block_labels.resize(count);
+    nearest.resize(count);
+    second.resize(count);
+
+    const AssignmentResult block = DistanceKernels<T>::assign_nearest_two(
+        points, count, centroids.data(), centroids.rows(), centroids.dimension(),
+        block_labels.data(), nearest.data(), second.data());
+    result.sum_distance += block.sum_distance;
+    result.sum_squared += block.sum_squared;
+    result.distance_evaluations += block.distance_evaluations;
+    for (size_t b = 0; b < count; ++b) {
+        const size_t i = rows ? rows[b] : first_row + b;
+        labels[i] = block_labels[b];
+        distances[i] = std::sqrt(static_cast<double>(nearest[b]));
+        lower_bounds[i] = std::sqrt(static_cast<double>(second[b]));
+    }
+}
+
+template <typename T>
+template <size_t D>
+AssignmentResult Individual<T>::assign_from(const PointMatrix<T>& data, const Individual<T>& parent) {
+    using Acc = typename DistanceKernels<T>::Acc;
+    const size_t n = data.rows();
+    const size_t k = centroids.rows();
+    const size_t dim = data.dimension();
+    labels.resize(n);
+    distances.resize(n);
+    lower_bounds.resize(n);
+    stale_labels = false;
+    labelled_points = &data;
+
+    // Per-thread scratch, reused between calls
+    thread_local std::vector<double> shift;
+    thread_local std::vector<double> half_gap;
+    thread_local std::vector<size_t> far;
+    thread_local std::vector<T> far_centroids;
+    thread_local std::vector<size_t> far_labels;
+    thread_local std::vector<Acc> far_nearest;
+    thread_local std::vector<Acc> far_second;
+    thread_local std::vector<size_t> rescan;
+    thread_local std::vector<T> gathered;
+    shift.resize(k);
+    half_gap.resize(k);
+    // Reserved for the worst case, so a later child with more far moves or
+    // failed bounds does not allocate
+    far.clear();
+    far.reserve(k);
+    far_centroids.clear();
+    far_centroids.reserve(k * dim);
+    rescan.clear();
+    rescan.reserve(n);
+
+    // Half the distance from each centroid to its closest neighbour: a point
+    // closer than that to its centroid cannot be closer to any other one
+    double min_half_gap = std::numeric_limits<double>::max();
+    for (size_t c = 0; c < k; ++c) {
+        double closest = std::numeric_limits<double>::max();
+        for (size_t other = 0; other < k; ++other) {
+            if (other == c) continue;
+            closest = std::min(closest, static_cast<double>(
+                DistanceKernels<T>::squared_distance(centroids.row(c), centroids.row(other), dim)));
         }
-        counts[cluster]++;
+        half_gap[c] = 0.5 * std::sqrt(closest);
+        min_half_gap = std::min(min_half_gap, half_gap[c]);
     }
-    
-    for (size_t i = 0; i < new_centroids.size(); ++i) {
-        if (counts[i] > 0) {
-            for (size_t j = 0; j < new_centroids[i].coors.size(); ++j) {
-                new_centroids[i].coors[j] /= static_cast<T>(counts[i]);
+
+    // Centroids that moved farther than any half gap (typically a crossover
+    // tail) would ruin the bounds of every point, so the distances to them are
+    // measured instead. Smaller moves (mutations) only loosen the bounds: the
+    // largest and second largest of them give the largest move of any
+    // centroid other than c in O(1).
+    size_t max_cluster = 0;
+    double max_shift = 0.0;
+    double second_shift = 0.0;
+    for (size_t c = 0; c < k; ++c) {
+        shift[c] = std::sqrt(static_cast<double>(
+            DistanceKernels<T>::squared_distance(centroids.row(c), parent.centroids.row(c), dim)));
+        if (shift[c] > min_half_gap) {
+            far.push_back(c);
+            far_centroids.insert(far_centroids.end(), centroids.row(c), centroids.row(c) + dim);
+        } else if (shift[c] > max_shift) {
+            second_shift = max_shift;
+            max_shift = shift[c];
+            max_cluster = c;
+        } else if (shift[c] > second_shift) {
+            second_shift = shift[c];
+        }
+    }
+    if (far.size() == k) {
+        return update_labels_with_bounds(data);
+    }
+    const size_t far_count = far.size();
+    far_labels.resize(bound_block_rows);
+    far_nearest.resize(bound_block_rows);
+    far_second.resize(bound_block_rows);
+
+    AssignmentResult result;
+    for (size_t first = 0; first < n; first += bound_block_rows) {
+        const size_t count = std::min(bound_block_rows, n - first);
+        if (far_count > 0) {
+            result.distance_evaluations += DistanceKernels<T>::assign_nearest_two(
+                data.row(first), count, far_centroids.data(), far_count, dim,
+                far_labels.data(), far_nearest.data(), far_second.data()).distance_evaluations;
+        }
+        for (size_t b = 0; b < count; ++b) {
+            const size_t i = first + b;
+            const size_t cluster = parent.labels[i];
+            const bool cluster_far = shift[cluster] > min_half_gap;
+            // Lower bound on the distance to every centroid that did not move far
+            const double lower = parent.lower_bounds[i] - (cluster == max_cluster ? second_shift : max_shift);
+
+            // The assigned centroid moved: its exact distance is needed for the fitness anyway
+            double upper = parent.distances[i];
+            if (shift[cluster] > 0.0 && !cluster_far) {
+                upper = std::sqrt(static_cast<double>(
+                    DistanceKernels<T>::template squared_distance<D>(data.row(i), centroids.row(cluster), dim)));
+                result.distance_evaluations++;
+            }
+
+            size_t best = cluster;
+            double best_distance = upper;
+            double runner_up = lower; // Lower bound on the distance to any other centroid
+            if (far_count > 0) {
+                const double nearest = static_cast<double>(far_nearest[b]);
+                const double second = static_cast<double>(far_second[b]);
+                if (cluster_far || nearest < upper * upper) {
+                    best = far[far_labels[b]];
+                    best_distance = std::sqrt(nearest);
+                    if (!cluster_far) runner_up = std::min(runner_up, upper);
+                    if (runner_up > 0.0 && second < runner_up * runner_up) runner_up = std::sqrt(second);
+                } else if (runner_up > 0.0 && nearest < runner_up * runner_up) {
+                    runner_up = std::sqrt(nearest);
+                }
+            }
+
+            if (best_distance > runner_up && best_distance > half_gap[best]) {
+                // Bounds are violated: compared with every centroid below
+                rescan.push_back(i);
+                continue;
             }
+            labels[i] = best;
+            distances[i] = best_distance;
+            lower_bounds[i] = runner_up;
+            result.sum_squared += best_distance * best_distance;
+            result.sum_distance += best_distance;
         }
     }
-    centroids = new_centroids;
-}
 
+    // Points whose bounds failed are gathered into blocks for the vector
+    // kernel instead of being compared with every centroid one at a time
+    gathered.resize(bound_block_rows * dim);
+    for (size_t first = 0; first < rescan.size(); first += bound_block_rows) {
+        const size_t count = std::min(bound_block_rows, rescan.size() - first);
+        for (size_t b = 0; b < count; ++b) {
+            const T* point = data.row(rescan[first + b]);
+            std::copy(point, point + dim, gathered.data() + b * dim);
+        }
+        assign_block(gathered.data(), count, rescan.data() + first, 0, result);
+    }
+    return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read access to a whole file through the virtual memory system
+// Pages are loaded on first touch instead of being copied through a stream.
+// The mapping is private: writes through data() are allowed, stay in this
+// process and never reach the file. Uses mmap on POSIX and file mappings
+// on Windows.
+class MappedFile {
+public:
+    // Maps the whole file
+    // Throws:
+    //   std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& filename);
+
+    // Unmaps the file
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // First byte of the file (nullptr for an empty file)
+    char* data() { return bytes; }
+    const char* data() const { return bytes; }
+
+    // Size of the file in bytes
+    size_t size() const { return length; }
+
+private:
+    char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+#include "MappedFile.ipp"
@@ -0,0 +1,78 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+inline MappedFile::MappedFile(const std::string& filename) {
+    file_handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        file_handle = nullptr;
+        throw std::runtime_error("Could not open the file: " + filename);
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("Could not read the size of file: " + filename);
+    }
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length == 0) return; // Windows refuses to map empty files
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (mapping_handle != nullptr) {
+        bytes = static_cast<char*>(MapViewOfFile(mapping_handle, FILE_MAP_COPY, 0, 0, 0));
+    }
+    if (bytes == nullptr) {
+        if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw std::runtime_error("Could not map the file: " + filename);
+    }
+}
+
+inline MappedFile::~MappedFile() {
+    if (bytes != nullptr) UnmapViewOfFile(bytes);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    if (file_handle != nullptr) CloseHandle(file_handle);
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+inline MappedFile::MappedFile(const std::string& filename) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open the file: " + filename);
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not read the size of file: " + filename);
+    }
+    length = static_cast<size_t>(info.st_size);
+
+    if (length > 0) {
+        void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Could not map the file: " + filename);
+        }
+        bytes = static_cast<char*>(address);
+    }
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+}
+
+inline MappedFile::~MappedFile() {
+    if (bytes != nullptr) ::munmap(bytes, length);
+}
+
+#endif
@@ -13,9 +13,16 @@ public:
     virtual ~MutationOperator() = default;
 
     // Pure virtual mutation operation
-    // point - reference to the point being mutated
+    // coors - coordinates being mutated (e.g. a PointMatrix row)
+    // dim - number of coordinates
     // rng - random number generator for probabilistic operations
-    virtual void mutate(Point<T>& point, std::mt19937& rng) = 0;
+    // Returns true if at least one coordinate changed
+    virtual bool mutate(T* coors, size_t dim, std::mt19937& rng) = 0;
+
+    // Mutates a standalone point
+    bool mutate(Point<T>& point, std::mt19937& rng) {
+        return mutate(point.coors.data(), point.dimension(), rng);
+    }
 };
 
 // Gaussian mutation for real-valued numbers (float/double)
@@ -32,9 +39,11 @@ public:
     GaussianMutation(double rate, double std_dev) 
         : mutation_rate(rate), sigma(std_dev) {}
     
+    using MutationOperator<T>::mutate;
+
     // Mutates each coordinate with probability mutation_rate
     // Adds Gaussian noise N(0, sigma) to selected coordinates
-    void mutate(Point<T>& point, std::mt19937& rng) override;
+    bool mutate(T* coors, size_t dim, std::mt19937& rng) override;
 };
 
 // Uniform integer mutation for discrete values
@@ -51,9 +60,11 @@ public:
     IntegerMutation(double rate, int max) 
         : mutation_rate(rate), max_change(max) {}
     
+    using MutationOperator<T>::mutate;
+
     // Mutates each coordinate with probability mutation_rate
     // Adds uniform random integer in [-max_change, +max_change]
-    void mutate(Point<T>& point, std::mt19937& rng) override;
+    bool mutate(T* coors, size_t dim, std::mt19937& rng) override;
 };
 
 #include "MutationOperator.ipp"
\ No newline at end of file
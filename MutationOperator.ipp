@@ -1,27 +1,35 @@
 #include "MutationOperator.h"
 
 template <typename T>
-void GaussianMutation<T>::mutate(Point<T>& point, std::mt19937& rng) {
+bool GaussianMutation<T>::mutate(T* coors, size_t dim, std::mt19937& rng) {
     std::uniform_real_distribution<double> prob(0.0, 1.0);
     std::normal_distribution<double> gauss(0.0, sigma);
+    bool changed = false;
     
-    for (size_t i = 0; i < point.dimension(); ++i) {
+    for (size_t i = 0; i < dim; ++i) {
         if (prob(rng) < mutation_rate) {
-            point.coors[i] += static_cast<T>(gauss(rng));
+            const T before = coors[i];
+            coors[i] += static_cast<T>(gauss(rng));
+            changed = changed || coors[i] != before;
         }
     }
+    return changed;
 }
 
 template <typename T>
-void IntegerMutation<T>::mutate(Point<T>& point, std::mt19937& rng) {
+bool IntegerMutation<T>::mutate(T* coors, size_t dim, std::mt19937& rng) {
     std::uniform_real_distribution<double> prob(0.0, 1.0);
     std::uniform_int_distribution<int> change(-max_change, max_change);
+    bool changed = false;
     
-    for (size_t i = 0; i < point.dimension(); ++i) {
+    for (size_t i = 0; i < dim; ++i) {
         if (prob(rng) < mutation_rate) {
-            point.coors[i] += static_cast<T>(change(rng));
+            const int delta = change(rng);
+            coors[i] += static_cast<T>(delta);
+            changed = changed || delta != 0;
         }
     }
+    return changed;
 }
 
 
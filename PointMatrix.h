@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <memory>
+#include "Point.h"
+
+// Memory layout of a PointMatrix
+// RowMajor    - coordinates of one point are contiguous (x0 y0 x1 y1 ...)
+// ColumnMajor - one coordinate of all points is contiguous (x0 x1 ... y0 y1 ...)
+enum class Layout { RowMajor, ColumnMajor };
+
+// A dense matrix of n points with a fixed dimension d stored in a single
+// contiguous buffer. Replaces std::vector<Point<T>> in hot loops, where each
+// Point owns a separate heap allocation.
+// A matrix may also be a view of memory it does not own (e.g. a memory
+// mapped file), kept alive by a shared owner. Copies of a view share that
+// memory; resize() turns a view into an ordinary owning matrix.
+// T - numeric type for point coordinates (e.g., double, float, int)
+template <typename T>
+class PointMatrix {
+private:
+    std::vector<T> values; // n * d coordinates in the order given by layout
+    size_t n;              // Number of points (rows)
+    size_t d;              // Dimension of every point (columns)
+    Layout order;          // Storage order of values
+    T* external;           // Coordinates of a view, nullptr when values are used
+    std::shared_ptr<void> external_owner; // Keeps the memory of a view alive
+
+public:
+    // Creates an empty matrix with zero points
+    PointMatrix();
+
+    // Creates a matrix of `rows` points of dimension `dim` filled with `fill`
+    PointMatrix(size_t rows, size_t dim, T fill = T(), Layout layout = Layout::RowMajor);
+
+    // Compatibility adapter: copies a vector of Points into contiguous storage
+    // Throws:
+    //   std::invalid_argument if the points have different dimensions
+    static PointMatrix from_points(const std::vector<Point<T>>& points,
+                                   Layout layout = Layout::RowMajor);
+
+    // Creates a row-major view of `rows` x `dim` coordinates owned by `owner`
+    // No data is copied; the memory must stay valid while `owner` lives
+    static PointMatrix view(T* coors, size_t rows, size_t dim, std::shared_ptr<void> owner);
+
+    // Converts back to a vector of Points
+    std::vector<Point<T>> to_points() const;
+
+    // Returns the i-th point as a standalone Point
+    Point<T> point(size_t i) const;
+
+    // Returns a copy of the matrix stored in the requested layout
+    PointMatrix with_layout(Layout layout) const;
+
+    // Changes the shape, keeping the layout. Reuses storage when possible.
+    void resize(size_t rows, size_t dim);
+
+    // Appends the points of another matrix (RowMajor only)
+    // Existing rows are not copied unless the storage has to grow, which
+    // happens geometrically; reserve() avoids it. An empty matrix takes the
+    // dimension of `other`. A view is detached first.
+    // Throws:
+    //   std::invalid_argument if the dimensions differ
+    //   std::logic_error if either matrix is not RowMajor
+    void append_rows(const PointMatrix& other);
+
+    // Preallocates storage for `rows` points of the current dimension
+    void reserve(size_t rows);
+
+    // Element access, valid for both layouts
+    T& operator()(size_t i, size_t j) { return storage()[index(i, j)]; }
+    const T& operator()(size_t i, size_t j) const { return storage()[index(i, j)]; }
+
+    // Pointer to the coordinates of the i-th point (RowMajor only)
+    T* row(size_t i) { return storage() + i * d; }
+    const T* row(size_t i) const { return storage() + i * d; }
+
+    // Pointer to the j-th coordinate of all points (ColumnMajor only)
+    T* column(size_t j) { return storage() + j * n; }
+    const T* column(size_t j) const { return storage() + j * n; }
+
+    // Copies the coordinates of a point into the i-th row (RowMajor only)
+    void set_row(size_t i, const T* coors);
+
+    T* data() { return storage(); }
+    const T* data() const { return storage(); }
+
+    size_t rows() const { return n; }
+    size_t dimension() const { return d; }
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    Layout layout() const { return order; }
+    bool is_view() const { return external != nullptr; }
+
+private:
+    T* storage() { return external ? external : values.data(); }
+    const T* storage() const { return external ? external : values.data(); }
+
+    size_t index(size_t i, size_t j) const {
+        return order == Layout::RowMajor ? i * d + j : j * n + i;
+    }
+};
+
+#include "PointMatrix.ipp"
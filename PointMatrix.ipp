@@ -0,0 +1,112 @@
+#include "PointMatrix.h"
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T>
+PointMatrix<T>::PointMatrix() : n(0), d(0), order(Layout::RowMajor), external(nullptr) {}
+
+template <typename T>
+PointMatrix<T>::PointMatrix(size_t rows, size_t dim, T fill, Layout layout)
+    : values(rows * dim, fill), n(rows), d(dim), order(layout), external(nullptr) {}
+
+template <typename T>
+PointMatrix<T> PointMatrix<T>::view(T* coors, size_t rows, size_t dim, std::shared_ptr<void> owner) {
+    PointMatrix<T> matrix;
+    matrix.n = rows;
+    matrix.d = dim;
+    matrix.external = coors;
+    matrix.external_owner = std::move(owner);
+    return matrix;
+}
+
+template <typename T>
+PointMatrix<T> PointMatrix<T>::from_points(const std::vector<Point<T>>& points, Layout layout) {
+    const size_t dim = points.empty() ? 0 : points[0].dimension();
+    PointMatrix<T> matrix(points.size(), dim, T(), layout);
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (points[i].dimension() != dim) {
+            throw std::invalid_argument("All points must have the same dimension");
+        }
+        for (size_t j = 0; j < dim; ++j) {
+            matrix(i, j) = points[i].coors[j];
+        }
+    }
+    return matrix;
+}
+
+template <typename T>
+std::vector<Point<T>> PointMatrix<T>::to_points() const {
+    std::vector<Point<T>> points;
+    points.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        points.push_back(point(i));
+    }
+    return points;
+}
+
+template <typename T>
+Point<T> PointMatrix<T>::point(size_t i) const {
+    std::vector<T> coors(d);
+    for (size_t j = 0; j < d; ++j) {
+        coors[j] = (*this)(i, j);
+    }
+    return Point<T>(coors);
+}
+
+template <typename T>
+PointMatrix<T> PointMatrix<T>::with_layout(Layout layout) const {
+    if (layout == order) return *this;
+
+    PointMatrix<T> result(n, d, T(), layout);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < d; ++j) {
+            result(i, j) = (*this)(i, j);
+        }
+    }
+    return result;
+}
+
+template <typename T>
+void PointMatrix<T>::resize(size_t rows, size_t dim) {
+    if (external) {
+        // Detach from the viewed memory, keeping the coordinates
+        values.assign(external, external + n * d);
+        external = nullptr;
+        external_owner.reset();
+    }
+    n = rows;
+    d = dim;
+    values.resize(rows * dim);
+}
+
+template <typename T>
+void PointMatrix<T>::append_rows(const PointMatrix<T>& other) {
+    if (order != Layout::RowMajor || other.order != Layout::RowMajor) {
+        throw std::logic_error("append_rows needs RowMajor matrices");
+    }
+    if (other.empty()) return;
+    if (empty() && d == 0) d = other.d;
+    if (other.d != d) {
+        throw std::invalid_argument("Appended points must have the same dimension");
+    }
+    if (external) {
+        values.assign(external, external + n * d);
+        external = nullptr;
+        external_owner.reset();
+    }
+
+    values.resize((n + other.n) * d);
+    std::copy(other.data(), other.data() + other.n * d, values.begin() + static_cast<std::ptrdiff_t>(n * d));
+    n += other.n;
+}
+
+template <typename T>
+void PointMatrix<T>::reserve(size_t rows) {
+    if (!external) values.reserve(rows * d);
+}
+
+template <typename T>
+void PointMatrix<T>::set_row(size_t i, const T* coors) {
+    std::copy(coors, coors + d, row(i));
+}
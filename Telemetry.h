@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <functional>
+#include <ostream>
+
+// Phases of a generation timed by GeneticClustering
+// Times of phases running on several workers are summed over the workers
+enum class Phase { Selection, Crossover, Mutation, Fitness, Refinement, Diversity };
+constexpr size_t phase_count = 6;
+
+// Lower case name of a phase ("selection", "crossover", ...)
+const char* phase_name(Phase phase);
+
+// Seconds spent in every phase, indexed by Phase
+struct PhaseTimes {
+    double seconds[phase_count] = {};
+
+    double& operator[](Phase phase) { return seconds[static_cast<size_t>(phase)]; }
+    double operator[](Phase phase) const { return seconds[static_cast<size_t>(phase)]; }
+
+    PhaseTimes& operator+=(const PhaseTimes& other);
+};
+
+// Measures one phase and adds its duration to a PhaseTimes when it ends
+// A null target makes the timer a no-op, so disabled telemetry does not
+// read the clock.
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseTimes* target, Phase phase);
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    PhaseTimes* times;
+    Phase measured;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Telemetry of one generation, or totals of a whole fit
+struct GenerationStats {
+    size_t generation = 0;            // Generation index (number of generations for totals)
+    double best_fitness = 0.0;
+    double average_fitness = 0.0;
+    double diversity = 0.0;           // 0 when diversity was not estimated
+    PhaseTimes phases;                // Time per phase
+    size_t evaluations = 0;           // Fitness evaluations (label passes)
+    size_t distance_evaluations = 0;  // Point-to-centroid distances computed
+    size_t allocations = 0;           // Heap allocations (0 unless the hook is enabled)
+    double seconds = 0.0;             // Wall time
+    double generations_per_second = 0.0;
+};
+
+// Receives telemetry from GeneticClustering::fit
+class FitObserver {
+public:
+    virtual ~FitObserver() = default;
+
+    // Called after every generation
+    virtual void on_generation(const GenerationStats& stats) = 0;
+
+    // Called once at the end of fit with totals over all generations
+    virtual void on_fit_end(const GenerationStats& totals) { (void)totals; }
+};
+
+// Forwards telemetry to callables (either may be empty)
+class CallbackObserver : public FitObserver {
+    std::function<void(const GenerationStats&)> generation_callback;
+    std::function<void(const GenerationStats&)> end_callback;
+
+public:
+    explicit CallbackObserver(std::function<void(const GenerationStats&)> on_generation,
+                              std::function<void(const GenerationStats&)> on_end = nullptr);
+
+    void on_generation(const GenerationStats& stats) override;
+    void on_fit_end(const GenerationStats& totals) override;
+};
+
+// Writes one JSON object per line: {"event":"generation",...} for every
+// generation and {"event":"fit_end",...} for the totals
+class JsonObserver : public FitObserver {
+    std::ostream& out;
+
+public:
+    explicit JsonObserver(std::ostream& stream) : out(stream) {}
+
+    void on_generation(const GenerationStats& stats) override;
+    void on_fit_end(const GenerationStats& totals) override;
+
+    // Writes the fields of stats as a JSON object without the event name
+    static void write_fields(std::ostream& stream, const GenerationStats& stats);
+};
+
+// Writes a CSV header followed by one row per generation and a final row
+// with the totals (event column "generation" or "fit_end")
+class CsvObserver : public FitObserver {
+    std::ostream& out;
+    bool header_written = false;
+
+public:
+    explicit CsvObserver(std::ostream& stream) : out(stream) {}
+
+    void on_generation(const GenerationStats& stats) override;
+    void on_fit_end(const GenerationStats& totals) override;
+
+private:
+    void write_row(const char* event, const GenerationStats& stats);
+};
+
+// Number of heap allocations made through the global operator new
+// Counting is enabled by defining GENETIC_CLUSTERING_COUNT_ALLOCATIONS
+// before including this header in exactly one translation unit (e.g. the
+// one with main), which then replaces the global operator new. Without it
+// the count stays 0.
+inline std::atomic<size_t>& allocation_count() {
+    static std::atomic<size_t> count{0};
+    return count;
+}
+
+#include "Telemetry.ipp"
@@ -0,0 +1,140 @@
+#include "Telemetry.h"
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+inline const char* phase_name(Phase phase) {
+    switch (phase) {
+        case Phase::Selection: return "selection";
+        case Phase::Crossover: return "crossover";
+        case Phase::Mutation: return "mutation";
+        case Phase::Fitness: return "fitness";
+        case Phase::Refinement: return "refinement";
+        default: return "diversity";
+    }
+}
+
+inline PhaseTimes& PhaseTimes::operator+=(const PhaseTimes& other) {
+    for (size_t p = 0; p < phase_count; ++p) {
+        seconds[p] += other.seconds[p];
+    }
+    return *this;
+}
+
+inline PhaseTimer::PhaseTimer(PhaseTimes* target, Phase phase) : times(target), measured(phase) {
+    if (times) start = std::chrono::steady_clock::now();
+}
+
+inline PhaseTimer::~PhaseTimer() {
+    if (times) {
+        (*times)[measured] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+inline CallbackObserver::CallbackObserver(std::function<void(const GenerationStats&)> on_generation,
+                                          std::function<void(const GenerationStats&)> on_end)
+    : generation_callback(std::move(on_generation)), end_callback(std::move(on_end)) {}
+
+inline void CallbackObserver::on_generation(const GenerationStats& stats) {
+    if (generation_callback) generation_callback(stats);
+}
+
+inline void CallbackObserver::on_fit_end(const GenerationStats& totals) {
+    if (end_callback) end_callback(totals);
+}
+
+inline void JsonObserver::write_fields(std::ostream& stream, const GenerationStats& stats) {
+    stream << "\"generation\":" << stats.generation
+           << ",\"best_fitness\":" << stats.best_fitness
+           << ",\"average_fitness\":" << stats.average_fitness
+           << ",\"diversity\":" << stats.diversity
+           << ",\"phases\":{";
+    for (size_t p = 0; p < phase_count; ++p) {
+        if (p > 0) stream << ",";
+        stream << "\"" << phase_name(static_cast<Phase>(p)) << "\":" << stats.phases.seconds[p];
+    }
+    stream << "},\"evaluations\":" << stats.evaluations
+           << ",\"distance_evaluations\":" << stats.distance_evaluations
+           << ",\"allocations\":" << stats.allocations
+           << ",\"seconds\":" << stats.seconds
+           << ",\"generations_per_second\":" << stats.generations_per_second;
+}
+
+inline void JsonObserver::on_generation(const GenerationStats& stats) {
+    out << "{\"event\":\"generation\",";
+    write_fields(out, stats);
+    out << "}\n";
+}
+
+inline void JsonObserver::on_fit_end(const GenerationStats& totals) {
+    out << "{\"event\":\"fit_end\",";
+    write_fields(out, totals);
+    out << "}" << std::endl;
+}
+
+inline void CsvObserver::write_row(const char* event, const GenerationStats& stats) {
+    if (!header_written) {
+        out << "event,generation,best_fitness,average_fitness,diversity";
+        for (size_t p = 0; p < phase_count; ++p) {
+            out << "," << phase_name(static_cast<Phase>(p)) << "_seconds";
+        }
+        out << ",evaluations,distance_evaluations,allocations,seconds,generations_per_second\n";
+        header_written = true;
+    }
+    out << event << "," << stats.generation << "," << stats.best_fitness << ","
+        << stats.average_fitness << "," << stats.diversity;
+    for (size_t p = 0; p < phase_count; ++p) {
+        out << "," << stats.phases.seconds[p];
+    }
+    out << "," << stats.evaluations << "," << stats.distance_evaluations << ","
+        << stats.allocations << "," << stats.seconds << "," << stats.generations_per_second << "\n";
+}
+
+inline void CsvObserver::on_generation(const GenerationStats& stats) {
+    write_row("generation", stats);
+}
+
+inline void CsvObserver::on_fit_end(const GenerationStats& totals) {
+    write_row("fit_end", totals);
+    out.flush();
+}
+
+#ifdef GENETIC_CLUSTERING_COUNT_ALLOCATIONS
+// Replacement global allocation functions counting every allocation
+// Defined only in the translation unit that enables the hook
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC pairs the inlined free() with the caller's operator new
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocation_count().fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
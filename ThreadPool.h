@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+// Fixed-size pool of worker threads running one task on every worker at a time
+// The calling thread takes part as worker 0, so a pool of size 1 starts no threads.
+// Dispatching a task does not allocate.
+class ThreadPool {
+public:
+    // Creates a pool with `threads` workers in total (including the caller)
+    explicit ThreadPool(size_t threads);
+
+    // Stops and joins all worker threads
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of workers, including the calling thread
+    size_t size() const { return workers.size() + 1; }
+
+    // Calls task(worker_index) once on every worker and waits for all of them
+    // The first exception thrown by any worker is rethrown to the caller
+    template <typename F>
+    void run(F& task) {
+        dispatch([](void* context, size_t worker) { (*static_cast<F*>(context))(worker); }, &task);
+    }
+
+private:
+    void dispatch(void (*invoke)(void*, size_t), void* task);
+    void worker_loop(size_t index);
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cv; // Signals a new task or shutdown
+    std::condition_variable done_cv;  // Signals that all workers finished the task
+
+    void (*job)(void*, size_t) = nullptr; // Current task
+    void* job_context = nullptr;
+    size_t generation = 0;   // Incremented for every dispatched task
+    size_t pending = 0;      // Workers still running the current task
+    bool stopping = false;
+    std::exception_ptr error;
+};
+
+#include "ThreadPool.ipp"
@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+inline ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 1; i < std::max<size_t>(threads, 1); ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+inline void ThreadPool::dispatch(void (*invoke)(void*, size_t), void* task) {
+    if (workers.empty()) {
+        invoke(task, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = invoke;
+        job_context = task;
+        pending = workers.size();
+        error = nullptr;
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    try {
+        invoke(task, 0);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+    }
+
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return pending == 0; });
+        std::swap(failure, error);
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+inline void ThreadPool::worker_loop(size_t index) {
+    size_t seen = 0;
+    for (;;) {
+        void (*invoke)(void*, size_t);
+        void* task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            invoke = job;
+            task = job_context;
+        }
+
+        try {
+            invoke(task, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) done_cv.notify_one();
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+// Pool of worker threads for many independent tasks of uneven length
+// Every worker owns a deque: it takes its own tasks from the back and, when
+// it runs dry, steals from the front of the other workers' deques.
+// Tasks submitted from inside a task go to the submitting worker's deque.
+class WorkStealingPool {
+public:
+    // Creates a pool with `threads` workers (0 = all hardware threads)
+    explicit WorkStealingPool(size_t threads = 0);
+
+    // Waits for the queued tasks, then stops and joins all workers
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Number of worker threads
+    size_t size() const { return workers.size(); }
+
+    // Queues a task for execution
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished (not to be called from a task)
+    // The first exception thrown by a task is rethrown here
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Takes a task from the worker's own deque or steals one from another
+    bool try_pop(size_t index, std::function<void()>& task);
+    void worker_loop(size_t index);
+
+    // Index of the pool worker running on this thread, or size() for other threads
+    size_t current_worker() const;
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_cv; // Signals queued tasks or shutdown
+    std::condition_variable done_cv; // Signals that all tasks finished
+    std::atomic<size_t> queued{0};   // Tasks waiting in the deques
+    size_t unfinished = 0;           // Tasks submitted but not yet finished
+    size_t next_queue = 0;           // Round-robin target for external submits
+    bool stopping = false;
+    std::exception_ptr error;
+
+    static inline thread_local const WorkStealingPool* owner = nullptr; // Pool of the current worker thread
+    static inline thread_local size_t owner_index = 0;                  // Index of the current worker thread
+};
+
+#include "WorkStealingPool.ipp"
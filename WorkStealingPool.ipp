@@ -0,0 +1,107 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+inline WorkStealingPool::WorkStealingPool(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+inline WorkStealingPool::~WorkStealingPool() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return unfinished == 0; });
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+inline size_t WorkStealingPool::current_worker() const {
+    return owner == this ? owner_index : workers.size();
+}
+
+inline void WorkStealingPool::submit(std::function<void()> task) {
+    size_t target = current_worker();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (target == workers.size()) {
+            target = next_queue;
+            next_queue = (next_queue + 1) % queues.size();
+        }
+        ++unfinished;
+        queued.fetch_add(1);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    work_cv.notify_one();
+}
+
+inline void WorkStealingPool::wait() {
+    std::exception_ptr failure;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [this] { return unfinished == 0; });
+        std::swap(failure, error);
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+inline bool WorkStealingPool::try_pop(size_t index, std::function<void()>& task) {
+    {
+        Queue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        Queue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+inline void WorkStealingPool::worker_loop(size_t index) {
+    owner = this;
+    owner_index = index;
+
+    std::function<void()> task;
+    for (;;) {
+        if (try_pop(index, task)) {
+            queued.fetch_sub(1);
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+            }
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinished == 0) done_cv.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        work_cv.wait(lock, [this] { return stopping || queued.load() > 0; });
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,181 @@
+// Throughput benchmark for GeneticClustering on standard synthetic datasets
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. benchmark/benchmark.cpp -o genetic_benchmark -pthread
+//
+// Usage:
+//   genetic_benchmark [--format csv|json] [--quick] [--threads N]
+//                     [--generations G] [--population P] [--seed S]
+//                     [--simd scalar|sse2|avx2|avx512]
+//
+// Every case runs a fixed number of generations with early stopping disabled,
+// so the work done only depends on the parameters and the seed, and results
+// can be compared across commits. One line per case is written to stdout.
+
+#define GENETIC_CLUSTERING_COUNT_ALLOCATIONS
+#include "GeneticClustering.h"
+#include "DistanceKernels.h"
+#include "PointMatrix.h"
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Dataset shape of one benchmark case
+struct BenchmarkCase {
+    size_t n; // Points
+    size_t d; // Dimension
+    size_t k; // Clusters (also the number of generated blobs)
+};
+
+struct BenchmarkOptions {
+    bool json = false;
+    bool quick = false;
+    size_t threads = 1;
+    size_t generations = 20;
+    size_t population = 50;
+    unsigned int seed = 42;
+};
+
+// Gaussian blobs like input/Generated.txt: k centers drawn uniformly from
+// [-10, 10]^d, points with unit standard deviation around them
+static std::shared_ptr<const PointMatrix<double>> make_blobs(const BenchmarkCase& c, unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> center_coordinate(-10.0, 10.0);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    PointMatrix<double> centers(c.k, c.d);
+    for (size_t i = 0; i < c.k; ++i) {
+        for (size_t j = 0; j < c.d; ++j) {
+            centers(i, j) = center_coordinate(rng);
+        }
+    }
+
+    auto points = std::make_shared<PointMatrix<double>>(c.n, c.d);
+    std::uniform_int_distribution<size_t> blob(0, c.k - 1);
+    for (size_t i = 0; i < c.n; ++i) {
+        const size_t b = blob(rng);
+        for (size_t j = 0; j < c.d; ++j) {
+            (*points)(i, j) = centers(b, j) + noise(rng);
+        }
+    }
+    return points;
+}
+
+static void write_header(const BenchmarkOptions& options) {
+    if (options.json) return;
+    std::cout << "n,d,k,threads,simd,population,generations,seconds,generations_per_second,"
+              << "evaluations,distance_evaluations,distances_per_second,allocations";
+    for (size_t p = 0; p < phase_count; ++p) {
+        std::cout << "," << phase_name(static_cast<Phase>(p)) << "_seconds";
+    }
+    std::cout << ",wcss\n";
+}
+
+static void write_result(const BenchmarkOptions& options, const BenchmarkCase& c,
+                         const GenerationStats& totals, double wcss) {
+    const double distances_per_second =
+        totals.seconds > 0.0 ? static_cast<double>(totals.distance_evaluations) / totals.seconds : 0.0;
+    const char* simd = simd_level_name(DistanceKernels<double>::simd_level());
+
+    if (options.json) {
+        std::cout << "{\"n\":" << c.n << ",\"d\":" << c.d << ",\"k\":" << c.k
+                  << ",\"threads\":" << options.threads << ",\"simd\":\"" << simd << "\""
+                  << ",\"population\":" << options.population
+                  << ",\"distances_per_second\":" << distances_per_second
+                  << ",\"wcss\":" << wcss << ",";
+        JsonObserver::write_fields(std::cout, totals);
+        std::cout << "}" << std::endl;
+        return;
+    }
+
+    std::cout << c.n << "," << c.d << "," << c.k << "," << options.threads << "," << simd << ","
+              << options.population << "," << totals.generation << "," << totals.seconds << ","
+              << totals.generations_per_second << "," << totals.evaluations << ","
+              << totals.distance_evaluations << "," << distances_per_second << ","
+              << totals.allocations;
+    for (size_t p = 0; p < phase_count; ++p) {
+        std::cout << "," << totals.phases.seconds[p];
+    }
+    std::cout << "," << wcss << std::endl;
+}
+
+static SimdLevel parse_simd(const std::string& name) {
+    if (name == "scalar") return SimdLevel::Scalar;
+    if (name == "sse2") return SimdLevel::SSE2;
+    if (name == "avx2") return SimdLevel::AVX2;
+    if (name == "avx512") return SimdLevel::AVX512;
+    throw std::invalid_argument("Unknown instruction set: " + name);
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--quick") {
+                options.quick = true;
+            } else if (arg == "--format" && has_value) {
+                const std::string format = argv[++i];
+                if (format != "csv" && format != "json") throw std::invalid_argument("Unknown format: " + format);
+                options.json = format == "json";
+            } else if (arg == "--threads" && has_value) {
+                options.threads = std::stoul(argv[++i]);
+            } else if (arg == "--generations" && has_value) {
+                options.generations = std::stoul(argv[++i]);
+            } else if (arg == "--population" && has_value) {
+                options.population = std::stoul(argv[++i]);
+            } else if (arg == "--seed" && has_value) {
+                options.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--simd" && has_value) {
+                DistanceKernels<double>::set_simd_level(parse_simd(argv[++i]));
+            } else {
+                throw std::invalid_argument("Unknown argument: " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n"
+                  << "Usage: " << argv[0] << " [--format csv|json] [--quick] [--threads N]"
+                  << " [--generations G] [--population P] [--seed S]"
+                  << " [--simd scalar|sse2|avx2|avx512]" << std::endl;
+        return 1;
+    }
+
+    // Standard cases: the kernel-specialized dimensions 2, 3 and 8 at growing sizes
+    std::vector<BenchmarkCase> cases = {
+        {10000, 2, 5}, {10000, 8, 5},
+        {100000, 2, 5}, {100000, 3, 10}, {100000, 8, 10}, {100000, 5, 20},
+        {1000000, 2, 5}, {1000000, 8, 20},
+    };
+    if (options.quick) {
+        cases.erase(std::remove_if(cases.begin(), cases.end(),
+                                   [](const BenchmarkCase& c) { return c.n > 100000; }),
+                    cases.end());
+    }
+
+    write_header(options);
+    for (const BenchmarkCase& c : cases) {
+        const auto data = make_blobs(c, options.seed);
+
+        GenerationStats totals;
+        GeneticClustering<double> gc(options.population, options.generations, 0.8, 0.05, c.k);
+        gc.set_seed(options.seed);
+        gc.set_num_threads(options.threads);
+        gc.set_stop_conditions(options.generations, 0, 0.0, 0.0);
+        gc.set_verbose(false);
+        gc.set_observer(new CallbackObserver(nullptr, [&](const GenerationStats& stats) { totals = stats; }));
+        gc.fit(data);
+        options.threads = gc.get_num_threads(); // Resolves 0 to the hardware thread count
+
+        write_result(options, c, totals, gc.getBestWCSS());
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+// Regression test: steady-state generations of GeneticClustering::fit must
+// not allocate
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -I. tests/allocations.cpp -o allocations_test -pthread
+//   ./allocations_test
+//
+// The test counts allocations with its own replacement of the global
+// operator new, so it needs nothing but the public fit interface. Two fits
+// with the same seed run a few warm-up generations (where per-thread scratch
+// buffers reach their final size) and then differ only by extra
+// generations, which must not change the count. A first fit is discarded,
+// as it also sizes scratch kept by the calling thread. Exits with 1 on failure.
+
+#include "GeneticClustering.h"
+#include "PointMatrix.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+// Generations that may still allocate while buffers grow
+constexpr size_t warm_up_generations = 5;
+// Generations that must not allocate
+constexpr size_t steady_generations = 25;
+
+static std::atomic<size_t> allocations{0};
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC pairs the inlined free() with the caller's operator new
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// Four Gaussian blobs in the plane
+static std::shared_ptr<const PointMatrix<double>> make_points(size_t n) {
+    std::mt19937 rng(11);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    auto points = std::make_shared<PointMatrix<double>>(n, 2);
+    for (size_t i = 0; i < n; ++i) {
+        (*points)(i, 0) = noise(rng) + 6.0 * static_cast<double>(i % 4);
+        (*points)(i, 1) = noise(rng) - 4.0 * static_cast<double>(i % 2);
+    }
+    return points;
+}
+
+// Allocations made by one complete fit of the given length
+static size_t count_fit(size_t population, size_t generations, size_t threads, bool incremental,
+                        const std::shared_ptr<const PointMatrix<double>>& points) {
+    GeneticClustering<double> gc(population, generations, 0.8, 0.05, 4);
+    gc.set_seed(7);
+    gc.set_num_threads(threads);
+    gc.set_incremental_assignment(incremental);
+    gc.set_stop_conditions(generations, 0, 1e-12, 0.0); // Diversity is estimated every generation
+    gc.set_verbose(false);
+    const size_t before = allocations.load();
+    gc.fit(points);
+    return allocations.load() - before;
+}
+
+// Returns 1 if the steady-state generations allocated
+static size_t check(const std::string& name, size_t population, size_t threads, bool incremental,
+                    const std::shared_ptr<const PointMatrix<double>>& points) {
+    count_fit(population, warm_up_generations, threads, incremental, points);
+    const size_t short_fit = count_fit(population, warm_up_generations, threads, incremental, points);
+    const size_t long_fit = count_fit(population, warm_up_generations + steady_generations, threads,
+                                      incremental, points);
+    if (long_fit != short_fit) {
+        std::cerr << name << ": " << steady_generations << " more generations made "
+                  << static_cast<long long>(long_fit) - static_cast<long long>(short_fit)
+                  << " more allocations\n";
+    }
+    std::cout << name << ": " << (long_fit == short_fit ? "ok" : "FAILED") << "\n";
+    return long_fit == short_fit ? 0 : 1;
+}
+
+int main() {
+    const auto points = make_points(4000);
+    size_t failures = 0;
+    // An odd population fills slots 1..P-1 with whole pairs; an even one
+    // writes the second child of the last pair to the spare individual
+    for (size_t population : {size_t(51), size_t(50)}) {
+        const std::string size = " (population " + std::to_string(population) + ")";
+        failures += check("serial" + size, population, 1, false, points);
+        failures += check("threaded" + size, population, 3, false, points);
+        failures += check("serial incremental" + size, population, 1, true, points);
+        failures += check("threaded incremental" + size, population, 3, true, points);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Regression test: a loaded checkpoint must be resumed with partial_fit before
+// it is evaluated, and corrupt segment starts must be rejected
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -I. tests/checkpoint.cpp -o checkpoint_test -pthread
+//   ./checkpoint_test
+//
+// get_best_solution, computeWCSS and getBestWCSS need the data, which is not
+// saved; right after load_checkpoint they have to throw instead of reading a
+// null data pointer. Exits with 1 on failure.
+
+#include "GeneticClustering.h"
+#include "PointMatrix.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+static const std::string checkpoint_file = "checkpoint_test.bin";
+static const std::string corrupt_file = "checkpoint_test_corrupt.bin";
+
+static PointMatrix<double> make_points(size_t n, double offset, std::mt19937& rng) {
+    std::normal_distribution<double> noise(0.0, 1.0);
+    PointMatrix<double> points(n, 2);
+    for (size_t i = 0; i < n; ++i) {
+        points(i, 0) = noise(rng) + offset * static_cast<double>(i % 3);
+        points(i, 1) = noise(rng) - offset * static_cast<double>(i % 2);
+    }
+    return points;
+}
+
+// Same settings for every instance; the seed is replaced by a loaded checkpoint
+static void configure(GeneticClustering<double>& gc) {
+    gc.set_seed(9);
+    gc.set_verbose(false);
+    gc.set_decay(0.5);
+}
+
+// Returns 1 unless call throws std::runtime_error
+static size_t expect_throw(const std::string& name, const std::function<void()>& call) {
+    try {
+        call();
+    } catch (const std::runtime_error&) {
+        std::cout << name << ": ok\n";
+        return 0;
+    }
+    std::cerr << name << ": no exception\n";
+    return 1;
+}
+
+// The file offset of the first segment start (found after rows and the segment count)
+static size_t segment_offset(const std::string& bytes, uint64_t rows, uint64_t segments) {
+    for (size_t pos = 0; pos + 16 <= bytes.size(); ++pos) {
+        uint64_t a, b;
+        std::memcpy(&a, bytes.data() + pos, sizeof(a));
+        std::memcpy(&b, bytes.data() + pos + 8, sizeof(b));
+        if (a == rows && b == segments) return pos + 16;
+    }
+    return bytes.size();
+}
+
+int main() {
+    std::mt19937 rng(4);
+    const PointMatrix<double> first = make_points(600, 6.0, rng);
+    const PointMatrix<double> second = make_points(400, 6.0, rng);
+    size_t failures = 0;
+
+    // Two batches with decay: the checkpoint holds two segments
+    {
+        GeneticClustering<double> gc(12, 5, 0.7, 0.05, 3);
+        configure(gc);
+        gc.partial_fit(first);
+        gc.partial_fit(second);
+        gc.save_checkpoint(checkpoint_file);
+    }
+
+    GeneticClustering<double> resumed(12, 5, 0.7, 0.05, 3);
+    configure(resumed);
+    resumed.load_checkpoint(checkpoint_file);
+    failures += expect_throw("get_best_solution after load", [&]() { resumed.get_best_solution(); });
+    failures += expect_throw("getBestWCSS after load", [&]() { resumed.getBestWCSS(); });
+    Individual<double> individual;
+    individual.centroids.resize(3, 2);
+    failures += expect_throw("computeWCSS after load", [&]() { resumed.computeWCSS(individual); });
+
+    // Resuming on the points seen so far makes the population usable again
+    PointMatrix<double> seen = first;
+    seen.append_rows(second);
+    resumed.partial_fit(seen);
+    const double wcss = resumed.getBestWCSS();
+    if (!(wcss > 0.0) || resumed.get_best_solution().labels.size() != seen.rows()) {
+        std::cerr << "resumed fit: WCSS " << wcss << "\n";
+        failures++;
+    } else {
+        std::cout << "resumed fit: ok\n";
+    }
+
+    // Segment starts must be 0, strictly increasing and below the row count
+    std::ifstream in(checkpoint_file, std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    const size_t offset = segment_offset(bytes, seen.rows(), 2);
+    if (offset == bytes.size()) {
+        std::cerr << "segment starts not found\n";
+        failures++;
+    } else {
+        // Each segment is stored as its start and its weight
+        const struct { const char* name; size_t segment; uint64_t start; } corruptions[] = {
+            {"first start not 0", 0, 7},
+            {"starts not increasing", 1, 0},
+            {"start past the rows", 1, seen.rows()},
+        };
+        for (const auto& corruption : corruptions) {
+            std::string corrupt = bytes;
+            std::memcpy(&corrupt[offset + corruption.segment * 16], &corruption.start, sizeof(uint64_t));
+            std::ofstream(corrupt_file, std::ios::binary) << corrupt;
+            GeneticClustering<double> gc(12, 5, 0.7, 0.05, 3);
+            configure(gc);
+            failures += expect_throw(corruption.name, [&]() { gc.load_checkpoint(corrupt_file); });
+        }
+    }
+
+    std::remove(checkpoint_file.c_str());
+    std::remove(corrupt_file.c_str());
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// Regression test: in mini-batch mode, every individual whose labels belong
+// to a point set must have the fitness, labels and bounds of its centroids
+// on that point set, with and without incremental assignment
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O2 -I. tests/minibatch_incremental.cpp -o minibatch_incremental_test -pthread
+//   ./minibatch_incremental_test
+//
+// The population is inspected every generation through the diversity
+// estimator hook and rescored from scratch. Bounds left over from an earlier
+// batch or an earlier occupant of a population slot show up as fitness
+// values or bounds that do not match. Exits with 1 on failure.
+
+#include "DiversityEstimator.h"
+#include "DistanceKernels.h"
+#include "GeneticClustering.h"
+#include "PointMatrix.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Relative difference allowed against the rescoring (summation order differs)
+constexpr double tolerance = 1e-9;
+
+// Five Gaussian blobs in three dimensions
+static std::shared_ptr<const PointMatrix<double>> make_points(size_t n) {
+    std::mt19937 rng(5);
+    std::normal_distribution<double> noise(0.0, 1.0);
+    auto points = std::make_shared<PointMatrix<double>>(n, 3);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            (*points)(i, j) = noise(rng) + 5.0 * static_cast<double>((i + j) % 5);
+        }
+    }
+    return points;
+}
+
+static bool close(double a, double b) {
+    return std::abs(a - b) <= tolerance * std::max({std::abs(a), std::abs(b), 1.0});
+}
+
+// Rescores every labelled individual of each generation; never reports convergence
+class RescoringCheck : public DiversityEstimator<double> {
+public:
+    explicit RescoringCheck(size_t data_rows) : rows(data_rows) {}
+
+    double estimate(const std::vector<Individual<double>>& population) override {
+        generation++;
+        for (size_t i = 0; i < population.size(); ++i) {
+            const Individual<double>& individual = population[i];
+            if (individual.labelled_points && !individual.dirty) check(i, individual);
+        }
+        return 1.0;
+    }
+
+    size_t checked = 0;
+    size_t with_bounds = 0;
+    size_t failures = 0;
+
+private:
+    void check(size_t slot, const Individual<double>& individual) {
+        const PointMatrix<double>& points = *individual.labelled_points;
+        const size_t n = points.rows();
+        const size_t k = individual.centroids.rows();
+        const size_t dim = points.dimension();
+        checked++;
+
+        std::vector<size_t> labels(n);
+        const AssignmentResult expected = DistanceKernels<double>::assign_nearest(
+            points.data(), n, individual.centroids.data(), k, dim, labels.data());
+        const double scale = static_cast<double>(rows) / static_cast<double>(n);
+        bool ok = close(individual.fitness, 1.0 / (1.0 + expected.sum_distance * scale)) &&
+                  individual.labels.size() == n;
+
+        const bool bounded = individual.distances.size() == n;
+        if (bounded) with_bounds++;
+        for (size_t p = 0; ok && p < n; ++p) {
+            const double assigned = std::sqrt(DistanceKernels<double>::squared_distance(
+                points.row(p), individual.centroids.row(individual.labels[p]), dim));
+            const double nearest = std::sqrt(DistanceKernels<double>::squared_distance(
+                points.row(p), individual.centroids.row(labels[p]), dim));
+            ok = close(assigned, nearest);
+            if (!bounded) continue;
+            ok = ok && close(individual.distances[p], assigned);
+            for (size_t c = 0; ok && c < k; ++c) {
+                if (c == individual.labels[p]) continue;
+                const double other = std::sqrt(DistanceKernels<double>::squared_distance(
+                    points.row(p), individual.centroids.row(c), dim));
+                ok = individual.lower_bounds[p] <= other + tolerance * std::max(other, 1.0);
+            }
+        }
+        if (!ok) {
+            std::cerr << "  generation " << generation << ", slot " << slot
+                      << ": labels, bounds or fitness do not match the centroids\n";
+            failures++;
+        }
+    }
+
+    size_t rows;
+    size_t generation = 0;
+};
+
+// Runs one fit and returns the number of inconsistent individuals
+static size_t check(const std::string& name, const std::shared_ptr<const PointMatrix<double>>& points,
+                    bool incremental, size_t interval, MemeticTarget memetic) {
+    constexpr size_t generations = 40;
+
+    GeneticClustering<double> gc(40, generations, 0.7, 0.05, 5);
+    gc.set_seed(3);
+    gc.set_incremental_assignment(incremental);
+    gc.set_minibatch(300, SamplingStrategy::Reservoir, interval);
+    gc.set_memetic(memetic, 2);
+    gc.set_stop_conditions(generations, 0, 1e-12, 0.0); // The check runs every generation
+    gc.set_verbose(false);
+    auto* rescoring = new RescoringCheck(points->rows());
+    gc.set_diversity_estimator(rescoring);
+    gc.fit(points);
+
+    size_t failures = rescoring->failures;
+    // Refined offspring may legitimately be left without bounds
+    const bool bounds_expected = incremental && memetic != MemeticTarget::Offspring;
+    if (rescoring->checked == 0 || (bounds_expected && rescoring->with_bounds == 0)) {
+        std::cerr << "  nothing was checked\n";
+        failures++;
+    }
+    std::cout << name << (incremental ? ", incremental" : "") << ": "
+              << (failures == 0 ? "ok" : "FAILED") << "\n";
+    return failures;
+}
+
+int main() {
+    const auto points = make_points(3000);
+    size_t failures = 0;
+    for (bool incremental : {false, true}) {
+        failures += check("fixed batch", points, incremental, 0, MemeticTarget::None);
+        failures += check("resampled batch", points, incremental, 3, MemeticTarget::None);
+        failures += check("resampled batch, refined offspring", points, incremental, 3, MemeticTarget::Offspring);
+        failures += check("resampled batch, refined elite", points, incremental, 3, MemeticTarget::Elite);
+    }
+    return failures == 0 ? 0 : 1;
+}